@@ -1,7 +1,16 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <iostream>
+#include <map>
+#include <thread>
 #include <boost/program_options.hpp>
 #include "ip_filter.h"
 
+#ifndef WINDOWS_SPECIFIC_FLAG
+#include <unistd.h>
+#endif
+
 namespace po = boost::program_options;
 
 static constexpr int kOk{};
@@ -13,16 +22,68 @@ static char const *const kAllowedOptions{
     "-h, --help            produce help message\n"
     "-i, --input-file      input file\n"
     "-o, --output-file     output file\n"
-    "-s, --use-standard    use the c++ standard: 17 or 23\n\0"
+    "-s, --use-standard    use the c++ standard: 17 or 23\n"
+    "--cidr-file           CIDR blocklist file, matching addresses are printed after the filters\n"
+    "--rules-file          octet rules file: \"pattern [output file]\" per line, e.g. 46.70.*.*, 10.0.0.0/8, any==46\n"
+    "--threads             number of threads parsing the input file and sorting the addresses\n"
+    "--max-memory          memory limit for addresses in MB, larger inputs are sorted in temporary files\n"
+    "--storage             address storage: vector, bitmap or auto (bitmap for dense --unique addresses)\n"
+    "--unique              print each address once\n"
+    "--limit               print only the N highest addresses of each filter, the input is not sorted\n"
+    "--aggregate           sum the counter columns per prefix: 8, 16, 24 or 32 (per address)\n"
+    "--top                 number of aggregated prefixes to print\n"
+    "--stats               print phase timings and line counters as JSON to stderr\n"
+    "--huge-pages          allocate large address arrays on huge pages (MAP_HUGETLB or transparent huge pages)\n"
+    "--follow              keep reading stdin, print the results on SIGUSR1, every --follow-interval and at EOF\n"
+    "--follow-interval     seconds between the results in --follow mode, 0 - only on SIGUSR1 and at EOF\n"
+    "--save-index          write the sorted addresses to a binary index file, reuse it while the input is unchanged\n"
+    "--load-index          read the sorted addresses from a binary index file instead of parsing the input\n\0"
 };
 static char const *const kInputFile{"input-file"};
 static char const *const kOutputFile{"output-file"};
 static char const *const kStandard{"use-standard"};
+static char const *const kCidrFile{"cidr-file"};
+static char const *const kRulesFile{"rules-file"};
+static char const *const kThreads{"threads"};
+static char const *const kMaxMemory{"max-memory"};
+static char const *const kStorage{"storage"};
+static char const *const kUnique{"unique"};
+static char const *const kLimit{"limit"};
+static char const *const kAggregate{"aggregate"};
+static char const *const kTop{"top"};
+static char const *const kStats{"stats"};
+static char const *const kHugePages{"huge-pages"};
+static char const *const kFollow{"follow"};
+static char const *const kFollowInterval{"follow-interval"};
+static char const *const kSaveIndex{"save-index"};
+static char const *const kLoadIndex{"load-index"};
+
+/// Фильтр в режиме --follow, которому обработчик сигнала передает запрос вывода
+static IpFilter *following{};
+
+static void RequestEmit(int) {
+    following->RequestEmit();
+}
 
 struct options_t {
     std::string const in{};
     std::string const out{};
     int const standard{};
+    std::string const cidr{};
+    std::string const rules{};
+    unsigned const threads{};
+    size_t const max_memory{};
+    IpFilter::Storage const storage{};
+    bool const unique{};
+    size_t const limit{};
+    int const aggregate{};
+    size_t const top{};
+    bool const stats{};
+    bool const huge_pages{};
+    bool const follow{};
+    std::chrono::seconds const follow_interval{};
+    std::string const save_index{};
+    std::string const load_index{};
 };
 
 std::optional<options_t> ParseOptions(int argc, char **argv) {
@@ -32,7 +93,22 @@ std::optional<options_t> ParseOptions(int argc, char **argv) {
             ("help,h", "produce help message")
             ("input-file,i", po::value<std::string>(), "input file")
             ("output-file,o", po::value<std::string>(), "use the c++ standard: 17 or 23")
-            ("use-standard,s", po::value<int>()->default_value(17), "output file");
+            ("use-standard,s", po::value<int>()->default_value(17), "output file")
+            ("cidr-file", po::value<std::string>(), "CIDR blocklist file")
+            ("rules-file", po::value<std::string>(), "octet rules file")
+            ("threads", po::value<unsigned>()->default_value(1), "number of threads parsing and sorting")
+            ("max-memory", po::value<size_t>(), "memory limit for addresses in MB")
+            ("storage", po::value<std::string>()->default_value("auto"), "address storage: vector, bitmap or auto")
+            ("unique", po::bool_switch(), "print each address once")
+            ("limit", po::value<size_t>()->default_value(0), "number of the highest addresses printed per filter")
+            ("aggregate", po::value<int>(), "sum the counter columns per prefix: 8, 16, 24 or 32")
+            ("top", po::value<size_t>()->default_value(10), "number of aggregated prefixes to print")
+            ("stats", po::bool_switch(), "print phase timings and line counters as JSON to stderr")
+            ("huge-pages", po::bool_switch(), "allocate large address arrays on huge pages")
+            ("follow", po::bool_switch(), "keep reading stdin and print the results on request")
+            ("follow-interval", po::value<unsigned>()->default_value(0), "seconds between the results in --follow mode")
+            ("save-index", po::value<std::string>()->default_value(""), "write the sorted addresses to a binary index file")
+            ("load-index", po::value<std::string>()->default_value(""), "read the sorted addresses from a binary index file");
 
     // Парсинг аргументов командной строки
     po::variables_map vm{};
@@ -63,18 +139,109 @@ std::optional<options_t> ParseOptions(int argc, char **argv) {
         out = vm[kOutputFile].as<std::string>();
         std::cout << "Output file was set to " << out << ".\n";
     }
-    return options_t{in, out, standard};
+    std::string cidr{};
+    if (vm.contains(kCidrFile)) {
+        cidr = vm[kCidrFile].as<std::string>();
+        std::cout << "CIDR file was set to " << cidr << ".\n";
+    }
+    std::string rules{};
+    if (vm.contains(kRulesFile)) {
+        rules = vm[kRulesFile].as<std::string>();
+        std::cout << "Rules file was set to " << rules << ".\n";
+    }
+    unsigned threads{vm[kThreads].as<unsigned>()};
+    // Потоки сверх числа ядер не ускоряют разбор, но каждый держит блоки чтения и части сортировки
+    if (unsigned const cores{std::thread::hardware_concurrency()}; cores != 0 && threads > cores) {
+        threads = cores;
+        std::cout << "Threads were limited to " << threads << ".\n";
+    }
+
+    static constexpr size_t kMegabyte{1 << 20};
+    size_t max_memory{};
+    if (vm.contains(kMaxMemory)) {
+        max_memory = vm[kMaxMemory].as<size_t>() * kMegabyte;
+        std::cout << "Memory limit was set to " << vm[kMaxMemory].as<size_t>() << " MB.\n";
+    }
+
+    static std::map<std::string, IpFilter::Storage> const kStorages{
+        {"vector", IpFilter::Storage::kVector},
+        {"bitmap", IpFilter::Storage::kBitmap},
+        {"auto", IpFilter::Storage::kAuto},
+    };
+    auto const storage{kStorages.find(vm[kStorage].as<std::string>())};
+    if (storage == kStorages.end()) {
+        std::cout << "Unknown storage " << vm[kStorage].as<std::string>() << ".\n";
+        return {};
+    }
+    bool const unique{vm[kUnique].as<bool>()};
+    size_t const limit{vm[kLimit].as<size_t>()};
+
+    static constexpr int kAggregateLengths[]{8, 16, 24, 32};
+    int aggregate{};
+    if (vm.contains(kAggregate)) {
+        aggregate = vm[kAggregate].as<int>();
+        if (std::ranges::find(kAggregateLengths, aggregate) == std::end(kAggregateLengths)) {
+            std::cout << "Unknown aggregation prefix /" << aggregate << ".\n";
+            return {};
+        }
+    }
+    size_t const top{vm[kTop].as<size_t>()};
+    bool const stats{vm[kStats].as<bool>()};
+    bool const huge_pages{vm[kHugePages].as<bool>()};
+    bool const follow{vm[kFollow].as<bool>()};
+    std::chrono::seconds const follow_interval{vm[kFollowInterval].as<unsigned>()};
+    std::string const save_index{vm[kSaveIndex].as<std::string>()};
+    std::string const load_index{vm[kLoadIndex].as<std::string>()};
+    return options_t{
+        in, out, standard, cidr, rules, threads, max_memory, storage->second, unique, limit, aggregate, top, stats,
+        huge_pages, follow, follow_interval, save_index, load_index
+    };
 }
 
 int main(int argc, char **argv) {
     if (auto const opt_options{ParseOptions(argc, argv)}; !opt_options.has_value()) {
         return kErrorParseOptions;
     } else {
-        auto const [in, out, standard]{opt_options.value()};
-        IpFilter ip_filter{in, out, standard};
-        if (!ip_filter.Parsing()) {
+        auto const [in, out, standard, cidr, rules, threads, max_memory, storage, unique, limit, aggregate, top, stats,
+            huge_pages, follow, follow_interval, save_index, load_index]{opt_options.value()};
+        HugePageResource huge{};
+        IpFilter ip_filter{in, out, standard, huge_pages ? &huge : std::pmr::get_default_resource()};
+        ip_filter.SetThreads(threads);
+        ip_filter.SetMaxMemory(max_memory);
+        ip_filter.SetStorage(storage);
+        ip_filter.SetUnique(unique);
+        ip_filter.SetLimit(limit);
+        ip_filter.SetStats(stats);
+        ip_filter.SetSaveIndex(save_index);
+        ip_filter.SetLoadIndex(load_index);
+        if (aggregate != 0) {
+            ip_filter.SetAggregation(aggregate, top);
+        }
+        if (!cidr.empty() && !ip_filter.LoadCidrFile(cidr)) {
+            std::cout << "Error reading CIDR file " << cidr << ".\n";
             return kErrorIpFilter;
         }
+        if (!rules.empty() && !ip_filter.LoadRulesFile(rules)) {
+            std::cout << "Error reading rules file " << rules << ".\n";
+            return kErrorIpFilter;
+        }
+        if (follow) {
+#ifndef WINDOWS_SPECIFIC_FLAG
+            following = &ip_filter;
+            std::signal(SIGUSR1, RequestEmit);
+            bool const followed{ip_filter.Follow(STDIN_FILENO, follow_interval)};
+#else
+            bool const followed{ip_filter.Follow(std::cin, follow_interval)};
+#endif
+            if (!followed) {
+                return kErrorIpFilter;
+            }
+        } else if (!ip_filter.Parsing()) {
+            return kErrorIpFilter;
+        }
+        if (stats) {
+            std::cerr << ip_filter.Stats().ToJson() << '\n';
+        }
         return kOk;
     }
 }
@@ -0,0 +1,228 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "input_generator.h"
+#include "ip_filter_kernels.h"
+#include "mapped_file.h"
+
+namespace {
+    static constexpr int64_t kMinLines{1'000};
+    static constexpr int64_t kMaxLines{100'000'000};
+    static constexpr int kLinesMultiplier{10};
+    static char const *const kMaxLinesFlag{"--max_lines="};
+    static char const *const kNullOutput{"/dev/null"};
+
+    /// Наибольший размер входного файла, задается --max_lines
+    int64_t max_lines{1'000'000};
+
+    /**
+     * @brief Входной файл из num_lines строк (InputGenerator)
+     * @details Файл создается один раз во временном каталоге. Он пишется под временным именем и переименовывается,
+     * поэтому прерванная запись или другой процесс бенчмарка не оставляют неполный файл под именем кэша
+     */
+    std::string const &input(int64_t const num_lines) {
+        static std::map<int64_t, std::string> files{};
+        auto &file{files[num_lines]};
+        if (file.empty()) {
+            std::filesystem::path const path{std::filesystem::temp_directory_path() /
+                                             ("ip_filter_bench_" + std::to_string(num_lines) + ".tsv")};
+            if (!std::filesystem::exists(path)) {
+                std::filesystem::path const part{path.string() + '.' + std::to_string(std::random_device{}())};
+                if (!InputGenerator{}.WriteFile(part.string(), static_cast<size_t>(num_lines))) {
+                    std::filesystem::remove(part);
+                    throw std::runtime_error{"Error writing input file " + part.string()};
+                }
+                std::filesystem::rename(part, path);
+            }
+            file = path.string();
+        }
+        return file;
+    }
+
+    /// Скорость в строках и байтах входного файла, одинаковая база для всех фаз
+    void set_rates(benchmark::State &state, std::string const &file) {
+        auto const iterations{static_cast<double>(state.iterations())};
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                                static_cast<int64_t>(std::filesystem::file_size(file)));
+        state.counters["lines"] = benchmark::Counter(iterations * static_cast<double>(state.range(0)),
+                                                     benchmark::Counter::kIsRate);
+    }
+
+    /// Разбор строки стандарта: parsing_cxx17 или parsing_cxx23
+    template<int Standard>
+    IpParser::Status parse_line(std::string_view const line, std::pmr::vector<uint32_t> &ips) {
+        if constexpr (Standard == 17) {
+            return IpFilterKernels::ParsingCxx17(line, ips);
+        } else {
+            return IpFilterKernels::ParsingCxx23(line, ips);
+        }
+    }
+
+    /// Разбор файла в контейнер адресов ядром стандарта
+    template<int Standard>
+    void parse(std::string_view const text, std::pmr::vector<uint32_t> &ips) {
+        MappedFile::ForEachLine(text, [&ips](std::string_view const line) { parse_line<Standard>(line, ips); });
+    }
+
+    /// Адреса файла по убыванию: оба стандарта дают одинаковый контейнер, сортировка одна (RadixSort)
+    std::pmr::vector<uint32_t> sorted(std::string_view const text) {
+        std::pmr::vector<uint32_t> ips{};
+        parse<17>(text, ips);
+        RadixSort::Descending(ips, std::identity{});
+        return ips;
+    }
+
+    /// Чтение: отображение файла и обход строк
+    void BM_Read(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        for (auto _: state) {
+            MappedFile const mapped{file};
+            size_t lines{};
+            MappedFile::ForEachLine(mapped.View(), [&lines](std::string_view const line) {
+                benchmark::DoNotOptimize(line.data());
+                ++lines;
+            });
+            benchmark::DoNotOptimize(lines);
+        }
+        set_rates(state, file);
+    }
+
+    /// Разбор строк в контейнер адресов ядром стандарта
+    template<int Standard>
+    void BM_Parse(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        MappedFile const mapped{file};
+        for (auto _: state) {
+            std::pmr::vector<uint32_t> ips{};
+            parse<Standard>(mapped.View(), ips);
+            benchmark::DoNotOptimize(ips.data());
+        }
+        set_rates(state, file);
+    }
+
+    /// Поразрядная сортировка по убыванию
+    void BM_Sort(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        MappedFile const mapped{file};
+        std::pmr::vector<uint32_t> parsed{};
+        parse<17>(mapped.View(), parsed);
+        for (auto _: state) {
+            state.PauseTiming();
+            auto ips{parsed};
+            state.ResumeTiming();
+            RadixSort::Descending(ips, std::identity{});
+            benchmark::DoNotOptimize(ips.data());
+        }
+        set_rates(state, file);
+    }
+
+    /// Параллельная поразрядная сортировка по убыванию во всех потоках процессора
+    void BM_SortParallel(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        MappedFile const mapped{file};
+        std::pmr::vector<uint32_t> parsed{};
+        parse<17>(mapped.View(), parsed);
+        unsigned const num_threads{std::max(std::thread::hardware_concurrency(), 1u)};
+        for (auto _: state) {
+            state.PauseTiming();
+            auto ips{parsed};
+            state.ResumeTiming();
+            RadixSort::Descending(ips, std::identity{}, num_threads);
+            benchmark::DoNotOptimize(ips.data());
+        }
+        state.counters["threads"] = num_threads;
+        set_rates(state, file);
+    }
+
+    /// Фильтры Otus по отсортированному контейнеру: filterSorted() или filter() стандарта 23, вывод в /dev/null
+    template<int Standard>
+    void BM_Filter(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        MappedFile const mapped{file};
+        IpFilter ip_filter{"", kNullOutput, Standard};
+        parse<Standard>(mapped.View(), IpFilterKernels::Ips(ip_filter));
+        ip_filter.Sorting(std::greater{});
+        for (auto _: state) {
+            if constexpr (Standard == 17) {
+                IpFilterKernels::FilterSorted(ip_filter);
+            } else {
+                IpFilterKernels::FilterCxx23(ip_filter);
+            }
+        }
+        set_rates(state, file);
+    }
+
+    /// Форматирование и вывод всех адресов в /dev/null
+    void BM_Write(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        MappedFile const mapped{file};
+        auto const ips{sorted(mapped.View())};
+        IpWriter dst{kNullOutput};
+        for (auto _: state) {
+            for (uint32_t const ip: ips) {
+                dst.Write(ip);
+            }
+            dst.Flush();
+        }
+        set_rates(state, file);
+    }
+
+    /// IpFilter::Parsing целиком, вывод в /dev/null
+    template<int Standard>
+    void BM_EndToEnd(benchmark::State &state) {
+        auto const &file{input(state.range(0))};
+        for (auto _: state) {
+            IpFilter ip_filter{file, kNullOutput, Standard};
+            ip_filter.SetStorage(IpFilter::Storage::kVector);
+            benchmark::DoNotOptimize(ip_filter.Parsing());
+        }
+        set_rates(state, file);
+    }
+
+    void register_benchmarks() {
+        auto const range{[](benchmark::internal::Benchmark *const bench) {
+            bench->RangeMultiplier(kLinesMultiplier)->Range(kMinLines, max_lines)->Unit(benchmark::kMillisecond);
+        }};
+        range(benchmark::RegisterBenchmark("read", BM_Read));
+        range(benchmark::RegisterBenchmark("parse/17", BM_Parse<17>));
+        range(benchmark::RegisterBenchmark("parse/23", BM_Parse<23>));
+        range(benchmark::RegisterBenchmark("sort", BM_Sort));
+        range(benchmark::RegisterBenchmark("sort/parallel", BM_SortParallel));
+        range(benchmark::RegisterBenchmark("filter/17", BM_Filter<17>));
+        range(benchmark::RegisterBenchmark("filter/23", BM_Filter<23>));
+        range(benchmark::RegisterBenchmark("write", BM_Write));
+        range(benchmark::RegisterBenchmark("end_to_end/17", BM_EndToEnd<17>));
+        range(benchmark::RegisterBenchmark("end_to_end/23", BM_EndToEnd<23>));
+    }
+}
+
+/**
+ * @brief Пропускная способность по фазам на сгенерированных входных файлах
+ * @details --max_lines=N - наибольший размер файла (1000..100000000 строк, по умолчанию 10^6),
+ * остальные аргументы передаются Google Benchmark
+ */
+int main(int argc, char **argv) {
+    std::vector<char *> args{};
+    for (int i{}; i < argc; ++i) {
+        if (std::string_view const arg{argv[i]}; arg.starts_with(kMaxLinesFlag)) {
+            max_lines = std::clamp(std::stoll(std::string{arg.substr(std::string_view{kMaxLinesFlag}.size())}),
+                                   static_cast<long long>(kMinLines), static_cast<long long>(kMaxLines));
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    int num_args{static_cast<int>(args.size())};
+    register_benchmarks();
+    benchmark::Initialize(&num_args, args.data());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "input_generator.h"
+#include "ip_filter_kernels.h"
+#include "perf_counters.h"
+
+namespace {
+    static constexpr size_t kNumLines{1 << 20};
+    static char const *const kNullOutput{"/dev/null"};
+    static char const *const kOutFlag{"--benchmark_out="};
+    static char const *const kOutFormatFlag{"--benchmark_out_format="};
+    static char const *const kDefaultOut{"--benchmark_out=ip_filter_kernels.json"};
+    static char const *const kDefaultOutFormat{"--benchmark_out_format=json"};
+
+    /// Строки входного файла (InputGenerator) без '\n'
+    std::vector<std::string> const &lines() {
+        static std::vector<std::string> const data{
+            [] {
+                InputGenerator generator{};
+                std::vector<std::string> vec(kNumLines);
+                for (auto &line: vec) {
+                    generator.Next(line);
+                }
+                return vec;
+            }()
+        };
+        return data;
+    }
+
+    /// Валидные адреса строк lines() в порядке файла
+    std::vector<uint32_t> const &addresses() {
+        static std::vector<uint32_t> const data{
+            [] {
+                std::vector<uint32_t> vec{};
+                for (auto const &line: lines()) {
+                    if (uint32_t ip{}; IpParser::Parse(IpParser::FirstField(line), ip) == IpParser::Status::kOk) {
+                        vec.push_back(ip);
+                    }
+                }
+                return vec;
+            }()
+        };
+        return data;
+    }
+
+    /**
+     * @brief Счетчики процессора на элемент и скорость в элементах
+     * @details Недоступные счетчики не попадают в отчет, метка бенчмарка сообщает, что счетчиков нет
+     */
+    void set_counters(benchmark::State &state, PerfCounters const &counters, size_t const num_items) {
+        double const items{static_cast<double>(state.iterations()) * static_cast<double>(num_items)};
+        state.SetItemsProcessed(static_cast<int64_t>(items));
+        for (size_t i{}; i < PerfCounters::kNumEvents; ++i) {
+            if (auto const value{counters.Value(static_cast<PerfCounters::Event>(i))}; value) {
+                state.counters[std::string{PerfCounters::kNames[i]}] = *value / items;
+            }
+        }
+        if (!counters.Any()) {
+            state.SetLabel("perf counters unavailable");
+        }
+    }
+
+    /**
+     * @brief Ядро над каждым элементом, счетчики на весь цикл бенчмарка
+     * @param items Элементы
+     * @param kernel Ядро: (элемент)
+     */
+    template<class Item, class Kernel>
+    void run(benchmark::State &state, std::vector<Item> const &items, Kernel kernel) {
+        PerfCounters counters{};
+        counters.Reset();
+        counters.Start();
+        for (auto _: state) {
+            for (auto const &item: items) {
+                kernel(item);
+            }
+        }
+        counters.Stop();
+        set_counters(state, counters, items.size());
+    }
+
+    /// Парсинг строки в контейнер адресов: parsing_cxx17 или parsing_cxx23
+    template<auto Parse>
+    void BM_Parsing(benchmark::State &state) {
+        std::pmr::vector<uint32_t> ips{};
+        ips.reserve(kNumLines);
+        run(state, lines(), [&ips](std::string const &line) {
+            Parse(line, ips);
+            if (ips.size() == kNumLines) {
+                benchmark::DoNotOptimize(ips.data());
+                ips.clear();
+            }
+        });
+    }
+
+    /// Выделение первого поля строки (прежний splitString)
+    void BM_FirstField(benchmark::State &state) {
+        run(state, lines(), [](std::string const &line) {
+            benchmark::DoNotOptimize(IpParser::FirstField(line));
+        });
+    }
+
+    /// Разбор октетов адреса (прежний parsingIpElements)
+    void BM_ParseOctets(benchmark::State &state) {
+        run(state, lines(), [](std::string const &line) {
+            uint32_t ip{};
+            benchmark::DoNotOptimize(IpParser::Parse(IpParser::FirstField(line), ip));
+            benchmark::DoNotOptimize(ip);
+        });
+    }
+
+    /// Конвертация поля в boost::asio::ip::address_v4 и состояние (путь parsing_cxx23)
+    void BM_ConvertToIp(benchmark::State &state) {
+        run(state, lines(), [](std::string const &line) {
+            benchmark::DoNotOptimize(IpFilterKernels::ConvertToIp(IpParser::FirstField(line)));
+        });
+    }
+
+    /// Поразрядная сортировка по убыванию в одном потоке, копия адресов не учитывается
+    void BM_Sorting(benchmark::State &state) {
+        IpFilter filter{};
+        auto &ips{IpFilterKernels::Ips(filter)};
+        PerfCounters counters{};
+        counters.Reset();
+        for (auto _: state) {
+            state.PauseTiming();
+            ips.assign(addresses().begin(), addresses().end());
+            state.ResumeTiming();
+            counters.Start();
+            filter.Sorting(std::greater{});
+            counters.Stop();
+            benchmark::DoNotOptimize(ips.data());
+        }
+        set_counters(state, counters, addresses().size());
+    }
+
+    /// Предикат Otus::task_*
+    template<class Pred>
+    void BM_Task(benchmark::State &state, Pred pred) {
+        run(state, addresses(), [&pred](uint32_t const ip) {
+            benchmark::DoNotOptimize(pred(ip));
+        });
+    }
+
+    /// Вывод адреса в буфер IpWriter, буфер сбрасывается в /dev/null
+    void BM_Print(benchmark::State &state) {
+        IpFilter filter{"", kNullOutput};
+        run(state, addresses(), [&filter](uint32_t const ip) {
+            IpFilterKernels::Print(filter, ip);
+        });
+    }
+
+    void register_benchmarks() {
+        benchmark::RegisterBenchmark("parsing_cxx17", BM_Parsing<IpFilterKernels::ParsingCxx17>);
+        benchmark::RegisterBenchmark("parsing_cxx23", BM_Parsing<IpFilterKernels::ParsingCxx23>);
+        benchmark::RegisterBenchmark("first_field", BM_FirstField);
+        benchmark::RegisterBenchmark("parse_octets", BM_ParseOctets);
+        benchmark::RegisterBenchmark("convert_to_ip", BM_ConvertToIp);
+        benchmark::RegisterBenchmark("sorting", BM_Sorting);
+        benchmark::RegisterBenchmark("task_1", BM_Task<decltype(Otus::task_1)>, Otus::task_1);
+        benchmark::RegisterBenchmark("task_2", BM_Task<decltype(Otus::task_2)>, Otus::task_2);
+        benchmark::RegisterBenchmark("task_3", BM_Task<decltype(Otus::task_3)>, Otus::task_3);
+        benchmark::RegisterBenchmark("task_4", BM_Task<decltype(Otus::task_4)>, Otus::task_4);
+        benchmark::RegisterBenchmark("print", BM_Print);
+    }
+}
+
+/**
+ * @brief Ядра IpFilter по отдельности со счетчиками процессора на элемент (строку или адрес)
+ * @details Счетчики cycles, instructions, branch_misses, llc_misses читаются через perf_event_open (PerfCounters).
+ * Отчет пишется в JSON ip_filter_kernels.json, если --benchmark_out не задан. Остальные аргументы
+ * передаются Google Benchmark
+ */
+int main(int argc, char **argv) {
+    std::vector<char *> args(argv, argv + argc);
+    bool has_out{};
+    bool has_format{};
+    for (int i{1}; i < argc; ++i) {
+        std::string_view const arg{argv[i]};
+        has_out = has_out || arg.starts_with(kOutFlag);
+        has_format = has_format || arg.starts_with(kOutFormatFlag);
+    }
+    std::string default_out{kDefaultOut};
+    std::string default_format{kDefaultOutFormat};
+    if (!has_out) {
+        args.push_back(default_out.data());
+    }
+    if (!has_format) {
+        args.push_back(default_format.data());
+    }
+    int num_args{static_cast<int>(args.size())};
+    benchmark::AddCustomContext("perf_counters", PerfCounters{}.Any() ? "perf_event_open" : "unavailable");
+    register_benchmarks();
+    benchmark::Initialize(&num_args, args.data());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <vector>
+#include "ip_filter_kernels.h"
+
+namespace {
+    using ip_t = boost::asio::ip::address_v4;
+    using erased_t = std::function<bool(ip_t const &)>;
+
+    static constexpr size_t kNumIps{1 << 20};
+    static char const *const kNullOutput{"/dev/null"};
+
+    /// Адреса с частыми октетами 1, 46 и 70, чтобы у предикатов были совпадения
+    std::vector<ip_t> const &ips() {
+        static std::vector<ip_t> const data{
+            [] {
+                static constexpr uint32_t kOctets[]{1, 46, 70};
+
+                std::mt19937 gen{2024};
+                std::vector<ip_t> vec(kNumIps);
+                std::ranges::generate(vec, [&gen] {
+                    uint32_t ip{};
+                    for (int i{}; i < 4; ++i) {
+                        ip = ip << 8 | (gen() % 4 == 0 ? kOctets[gen() % std::size(kOctets)] : gen() & 0xFF);
+                    }
+                    return ip_t{ip};
+                });
+                return vec;
+            }()
+        };
+        return data;
+    }
+
+    /// Прежний путь IpFilter::filter: предикат в std::function и std::views::filter, вывод в /dev/null
+    void BM_Erased(benchmark::State &state, erased_t const &func) {
+        IpFilter filter{"", kNullOutput};
+        auto const &vec{ips()};
+        for (auto _: state) {
+            for (auto const &ip: vec | std::views::filter(func)) {
+                IpFilterKernels::Print(filter, ip.to_uint());
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kNumIps));
+    }
+
+    /// Путь IpFilter::filter_blocks: блоки контейнера фильтра, встроенный предикат, вывод в /dev/null
+    template<class Pred>
+    void BM_Compiled(benchmark::State &state, Pred pred) {
+        IpFilter filter{"", kNullOutput};
+        // Контейнер не отсортирован, поэтому префиксы task_2 и task_3 тоже проверяются блоками
+        std::ranges::transform(ips(), std::back_inserter(IpFilterKernels::Ips(filter)), &ip_t::to_uint);
+        for (auto _: state) {
+            IpFilterKernels::FilterOne(filter, pred);
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kNumIps));
+    }
+}
+
+BENCHMARK_CAPTURE(BM_Erased, task_2, erased_t{Otus::task_2});
+BENCHMARK_CAPTURE(BM_Compiled, task_2, Otus::task_2);
+BENCHMARK_CAPTURE(BM_Erased, task_3, erased_t{Otus::task_3});
+BENCHMARK_CAPTURE(BM_Compiled, task_3, Otus::task_3);
+BENCHMARK_CAPTURE(BM_Erased, task_4, erased_t{Otus::task_4});
+BENCHMARK_CAPTURE(BM_Compiled, task_4, Otus::task_4);
+
+BENCHMARK_MAIN();
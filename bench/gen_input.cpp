@@ -0,0 +1,26 @@
+#include <iostream>
+#include <string>
+#include "input_generator.h"
+
+/**
+ * @brief Генератор входного файла для замеров
+ * @details ip_filter_gen <файл> <количество строк> [зерно]. Одинаковые аргументы дают одинаковый файл
+ */
+int main(int argc, char **argv) {
+    static constexpr int kMinArgs{3};
+    static constexpr int kSeedArg{3};
+
+    if (argc < kMinArgs) {
+        std::cout << "Usage: " << argv[0] << " <file> <lines> [seed]\n";
+        return 1;
+    }
+    InputGenerator::Options options{};
+    if (kSeedArg < argc) {
+        options.seed = std::stoull(argv[kSeedArg]);
+    }
+    if (!InputGenerator{options}.WriteFile(argv[1], std::stoull(argv[2]))) {
+        std::cout << "Error writing " << argv[1] << ".\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Детерминированный генератор входного файла
+ * @details Строка: "a.b.c.d\trequests\tbytes". Распределение близко к рабочему:
+ * - адреса сосредоточены в небольшом наборе "горячих" префиксов /16, ранг префикса распределен геометрически;
+ * - часть адресов повторяет ранее выданные;
+ * - часть строк невалидна (все причины IpParser::Status по очереди).
+ * Используются только значения std::mt19937_64 без std::*_distribution, поэтому файл одинаков на всех платформах
+ */
+class InputGenerator {
+public:
+    /// Параметры распределения
+    struct Options {
+        /// Зерно генератора
+        uint64_t seed{2024};
+        /// Доля невалидных строк, на 1000 строк
+        uint32_t invalid_per_mille{10};
+        /// Доля повторов ранее выданных адресов, на 1000 строк
+        uint32_t duplicate_per_mille{100};
+        /// Доля адресов из горячих префиксов, на 1000 строк
+        uint32_t hot_per_mille{600};
+        /// Количество горячих префиксов /16
+        uint32_t num_hot{256};
+    };
+
+    InputGenerator() : InputGenerator{Options{}} {
+    }
+
+    explicit InputGenerator(Options const &options) : options{options}, gen{options.seed} {
+        hot.resize(std::max(options.num_hot, kMinHot));
+        for (auto &prefix: hot) {
+            prefix = static_cast<uint32_t>(gen()) & kPrefixMask;
+        }
+        // Префиксы из заданий, чтобы у фильтров были совпадения
+        hot[0] = 0x2E460000;
+        hot[1] = 0x01000000 | (hot[1] & 0x00FF0000);
+    }
+
+    /**
+     * @brief Следующая строка
+     * @param line Строка без '\n'
+     */
+    void Next(std::string &line) {
+        line.clear();
+        uint64_t const roll{gen() % kPerMille};
+        if (roll < options.invalid_per_mille) {
+            invalid(line);
+        } else {
+            append_ip(line, roll < options.invalid_per_mille + options.duplicate_per_mille && recent_pos != 0
+                                ? recent[gen() % std::min(recent_pos, kRecentSize)]
+                                : address());
+        }
+        line += '\t';
+        // Счетчики с тяжелым хвостом (логарифм равномерен): запросы до 2^14, байты пропорциональны запросам
+        int const shift{static_cast<int>(gen() % kCounterShifts) + kCounterBase};
+        uint64_t const requests{gen() >> shift};
+        line += std::to_string(requests);
+        line += '\t';
+        line += std::to_string(requests * (gen() % kMaxBytesPerRequest));
+    }
+
+    /**
+     * @brief Записать файл
+     * @param file Путь до файла
+     * @param num_lines Количество строк
+     * @return true - Файл записан
+     */
+    bool WriteFile(std::string const &file, size_t const num_lines) {
+        std::ofstream dst{file, std::ios::binary};
+        std::string line{};
+        for (size_t i{}; i < num_lines && dst; ++i) {
+            Next(line);
+            line += '\n';
+            dst.write(line.data(), static_cast<std::streamsize>(line.size()));
+        }
+        return static_cast<bool>(dst);
+    }
+
+private:
+    static constexpr uint64_t kPerMille{1000};
+    static constexpr uint32_t kPrefixMask{0xFFFF0000};
+    static constexpr uint32_t kMinHot{2};
+    static constexpr size_t kRecentSize{1 << 12};
+    static constexpr uint64_t kCounterShifts{14};
+    static constexpr int kCounterBase{50};
+    static constexpr uint64_t kMaxBytesPerRequest{2000};
+
+    /// Новый адрес: из горячего префикса с геометрическим рангом или равномерно
+    uint32_t address() {
+        uint32_t ip{static_cast<uint32_t>(gen())};
+        if (gen() % kPerMille < options.hot_per_mille) {
+            // Ранг r выбирается с вероятностью 2^-(r+1)
+            size_t const rank{static_cast<size_t>(std::countr_zero(gen() | (uint64_t{1} << 63)))};
+            ip = hot[rank % hot.size()] | (ip & ~kPrefixMask);
+        }
+        recent[recent_pos++ % kRecentSize] = ip;
+        return ip;
+    }
+
+    /// Невалидная строка адреса
+    void invalid(std::string &line) {
+        static constexpr std::array<char const *, 4> kInvalid{
+            "255.255.255.2555",
+            "1.2.3",
+            "1.2.x.4",
+            "1.2.3.256",
+        };
+        line += kInvalid[invalid_pos++ % kInvalid.size()];
+    }
+
+    static void append_ip(std::string &line, uint32_t const ip) {
+        for (int shift{24}; shift >= 0; shift -= 8) {
+            line += std::to_string(ip >> shift & 0xFF);
+            if (shift != 0) {
+                line += '.';
+            }
+        }
+    }
+
+    Options const options;
+    std::mt19937_64 gen;
+    /// Горячие префиксы /16
+    std::vector<uint32_t> hot{};
+    /// Недавние адреса для повторов
+    std::vector<uint32_t> recent = std::vector<uint32_t>(kRecentSize);
+    size_t recent_pos{};
+    size_t invalid_pos{};
+};
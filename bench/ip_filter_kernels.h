@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+#include "ip_filter.h"
+
+/**
+ * @brief Доступ бенчмарков к закрытым ядрам IpFilter
+ * @details Друг IpFilter, объявлен в ip_filter.h. Бенчмарки вызывают те же функции, что и Parsing(),
+ * а не их копии
+ */
+struct IpFilterKernels {
+    static IpParser::Status ParsingCxx17(std::string_view const line, std::pmr::vector<uint32_t> &ips) {
+        return IpFilter::parsing_cxx17(line, ips);
+    }
+
+    static IpParser::Status ParsingCxx23(std::string_view const line, std::pmr::vector<uint32_t> &ips) {
+        return IpFilter::parsing_cxx23(line, ips);
+    }
+
+    static auto ConvertToIp(std::string_view const field) {
+        return IpFilter::convert_to_ip(field);
+    }
+
+    /// Контейнер адресов фильтра для Sorting()
+    static std::pmr::vector<uint32_t> &Ips(IpFilter &filter) {
+        return filter.ips;
+    }
+
+    static void Print(IpFilter &filter, uint32_t const ip) {
+        filter.print(ip);
+    }
+
+    /**
+     * @brief Фильтрация адресов фильтра одной функцией, как filter() стандарта 23
+     * @details Функция от uint32_t без префикса или контейнер не по убыванию - проверка блоками (filter_blocks)
+     */
+    template<class Func>
+    static void FilterOne(IpFilter &filter, Func const &func) {
+        filter.filter_one(func);
+    }
+
+    /// Вывод фильтров по отсортированному контейнеру, как в parsingCxx17()
+    static void FilterSorted(IpFilter &filter) {
+        filter.filterSorted();
+    }
+
+    /// Вывод фильтров по отсортированному контейнеру, как в parsingCxx23()
+    static void FilterCxx23(IpFilter &filter) {
+        filter.filterCxx23();
+    }
+};
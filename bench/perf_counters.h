@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Аппаратные счетчики процессора для текущего потока (Linux perf_event_open)
+ * @details Каждый счетчик открывается отдельно: недоступный счетчик (нет поддержки процессора или виртуальной
+ * машины, запрет kernel.perf_event_paranoid, сборка не под Linux) пропускается, остальные работают.
+ * Считается только код пользователя. Если ядро мультиплексирует счетчики, значения масштабируются
+ * по доле времени, когда счетчик был на процессоре
+ */
+class PerfCounters {
+public:
+    /// Счетчик
+    enum class Event : uint8_t {
+        kCycles,
+        kInstructions,
+        kBranchMisses,
+        /// Промахи чтения кеша последнего уровня
+        kLlcMisses,
+    };
+
+    static constexpr size_t kNumEvents{4};
+
+    /// Имена счетчиков в отчете, по порядку Event
+    static constexpr std::array<std::string_view, kNumEvents> kNames{
+        "cycles", "instructions", "branch_misses", "llc_misses"
+    };
+
+    PerfCounters() {
+#ifdef __linux__
+        static constexpr std::array<std::pair<uint32_t, uint64_t>, kNumEvents> kEvents{{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                 PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+        }};
+
+        for (size_t i{}; i < kNumEvents; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = kEvents[i].first;
+            attr.config = kEvents[i].second;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int const fd: fds) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(PerfCounters const &) = delete;
+
+    PerfCounters &operator=(PerfCounters const &) = delete;
+
+    /// Счетчик открыт
+    [[nodiscard]] bool Available(Event const event) const {
+        return fds[static_cast<size_t>(event)] != -1;
+    }
+
+    /// Открыт хотя бы один счетчик
+    [[nodiscard]] bool Any() const {
+        for (int const fd: fds) {
+            if (fd != -1) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Начать счет. Start() и Stop() можно чередовать, значения накапливаются до Reset()
+    void Start() {
+        enable(true);
+    }
+
+    /// Остановить счет
+    void Stop() {
+        enable(false);
+    }
+
+    /// Обнулить накопленные значения
+    void Reset() {
+        for (size_t i{}; i < kNumEvents; ++i) {
+            base[i] = read(i);
+        }
+    }
+
+    /**
+     * @brief Накопленное значение с последнего Reset()
+     * @return Пусто, если счетчик недоступен или ни разу не был на процессоре
+     */
+    [[nodiscard]] std::optional<double> Value(Event const event) const {
+        auto const i{static_cast<size_t>(event)};
+        if (fds[i] == -1) {
+            return {};
+        }
+        Sample const now{read(i)};
+        uint64_t const running{now.running - base[i].running};
+        if (running == 0) {
+            return {};
+        }
+        return static_cast<double>(now.value - base[i].value) *
+               (static_cast<double>(now.enabled - base[i].enabled) / static_cast<double>(running));
+    }
+
+private:
+    /// Значение счетчика и время: включен, на процессоре (формат read с PERF_FORMAT_TOTAL_TIME_*)
+    struct Sample {
+        uint64_t value{};
+        uint64_t enabled{};
+        uint64_t running{};
+    };
+
+    void enable([[maybe_unused]] bool const on) {
+#ifdef __linux__
+        for (int const fd: fds) {
+            if (fd != -1) {
+                ioctl(fd, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    [[nodiscard]] Sample read([[maybe_unused]] size_t const i) const {
+        Sample sample{};
+#ifdef __linux__
+        if (fds[i] != -1 && ::read(fds[i], &sample, sizeof(sample)) != static_cast<ssize_t>(sizeof(sample))) {
+            sample = {};
+        }
+#endif
+        return sample;
+    }
+
+    /// Дескрипторы счетчиков, -1 - счетчик недоступен
+    std::array<int, kNumEvents> fds{-1, -1, -1, -1};
+    /// Значения на момент Reset()
+    std::array<Sample, kNumEvents> base{};
+};
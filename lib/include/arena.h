@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Арена: ресурс памяти с выделением сдвигом указателя
+ * @details Память берется у upstream блоками по BlockSize байт (запрос больше блока получает свой блок).
+ * deallocate() ничего не делает, вся память возвращается в Release() или в деструкторе.
+ * Подходит для временных данных одной пачки: частей файла при парсинге в нескольких потоках.
+ * Не потокобезопасна, у каждого потока своя арена
+ * @tparam BlockSize Размер блока в байтах
+ */
+template<size_t BlockSize = 1 << 20>
+class Arena : public std::pmr::memory_resource {
+public:
+    /**
+     * @brief Конструктор
+     * @param upstream Ресурс, у которого берутся блоки
+     */
+    explicit Arena(std::pmr::memory_resource *const upstream = std::pmr::get_default_resource()) : upstream{upstream} {
+    }
+
+    ~Arena() override {
+        Release();
+    }
+
+    Arena(Arena const &) = delete;
+
+    Arena &operator=(Arena const &) = delete;
+
+    /// Вернуть все блоки upstream
+    void Release() {
+        for (auto const &[ptr, size]: blocks) {
+            upstream->deallocate(ptr, size, alignof(std::max_align_t));
+        }
+        blocks.clear();
+        cur = nullptr;
+        end = nullptr;
+        used = 0;
+    }
+
+    /// Выделено байт (с учетом выравнивания)
+    [[nodiscard]] size_t Used() const {
+        return used;
+    }
+
+    /// Количество блоков, взятых у upstream
+    [[nodiscard]] size_t NumBlocks() const {
+        return blocks.size();
+    }
+
+private:
+    void *do_allocate(size_t const bytes, size_t const alignment) override {
+        auto const aligned{(reinterpret_cast<uintptr_t>(cur) + alignment - 1) & ~(uintptr_t{alignment} - 1)};
+        if (cur == nullptr || reinterpret_cast<uintptr_t>(end) < aligned + bytes) {
+            size_t const size{std::max(BlockSize, bytes + alignment)};
+            auto *const block{static_cast<std::byte *>(upstream->allocate(size, alignof(std::max_align_t)))};
+            blocks.emplace_back(block, size);
+            cur = block;
+            end = block + size;
+            return do_allocate(bytes, alignment);
+        }
+        auto *const ptr{reinterpret_cast<std::byte *>(aligned)};
+        used += static_cast<size_t>(ptr + bytes - cur);
+        cur = ptr + bytes;
+        return ptr;
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {
+    }
+
+    [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override {
+        return this == &other;
+    }
+
+    /// Ресурс блоков
+    std::pmr::memory_resource *const upstream;
+    /// Блоки: (начало, размер)
+    std::vector<std::pair<std::byte *, size_t> > blocks{};
+    /// Свободная часть текущего блока
+    std::byte *cur{};
+    std::byte *end{};
+    /// Выделено байт
+    size_t used{};
+};
+
+/**
+ * @brief Ресурс памяти со счетчиками выделений
+ * @details Передает запросы upstream и считает количество выделений, занятые байты и их максимум.
+ * Счетчики атомарные: ресурс может использоваться из нескольких потоков
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    /**
+     * @brief Конструктор
+     * @param upstream Ресурс, которому передаются запросы
+     */
+    explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+
+    /// Количество выделений
+    [[nodiscard]] uint64_t Allocations() const;
+
+    /// Занято байт
+    [[nodiscard]] size_t InUse() const;
+
+    /// Максимум занятых байт
+    [[nodiscard]] size_t Peak() const;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override;
+
+    /// Ресурс, которому передаются запросы
+    std::pmr::memory_resource *const upstream;
+    std::atomic<uint64_t> allocations{};
+    std::atomic<size_t> in_use{};
+    std::atomic<size_t> peak{};
+};
+
+/**
+ * @brief Ресурс памяти для крупных массивов на больших страницах
+ * @details Подключается явно: передается в IpFilter как ресурс контейнеров (--huge-pages), ниже его
+ * CountingResource и арен частей. Запросы от MinBytes() байт берутся анонимным отображением памяти: сначала с MAP_HUGETLB
+ * (страницы 2 МиБ из пула vm.nr_hugepages), если пул пуст или не настроен - обычным отображением,
+ * выровненным на 2 МиБ, с madvise(MADV_HUGEPAGE) для прозрачных больших страниц. После первого отказа
+ * MAP_HUGETLB больше не запрашивается. Большие страницы уменьшают промахи TLB в сортировке и фильтрах.
+ * Меньшие запросы, запросы с выравниванием больше страницы и все запросы вне Linux передаются upstream.
+ * Потокобезопасен, если потокобезопасен upstream
+ */
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    /// Размер большой страницы
+    static constexpr size_t kHugePageSize{1 << 21};
+
+    /**
+     * @brief Конструктор
+     * @param upstream Ресурс для небольших запросов
+     * @param min_bytes Наименьший запрос, который получает отображение
+     */
+    explicit HugePageResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource(),
+                              size_t min_bytes = kHugePageSize);
+
+    /// Наименьший запрос, который получает отображение
+    [[nodiscard]] size_t MinBytes() const;
+
+    /// Количество выделений отображением
+    [[nodiscard]] uint64_t Mapped() const;
+
+    /// Количество выделений отображением с MAP_HUGETLB
+    [[nodiscard]] uint64_t HugeTlb() const;
+
+private:
+    /// Запрос выделяется отображением
+    [[nodiscard]] bool isMapped(size_t bytes, size_t alignment) const;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override;
+
+    /// Ресурс для небольших запросов
+    std::pmr::memory_resource *const upstream;
+    size_t const min_bytes;
+    std::atomic<uint64_t> mapped{};
+    std::atomic<uint64_t> huge_tlb{};
+    /// MAP_HUGETLB отказал, дальше только прозрачные большие страницы
+    std::atomic<bool> no_huge_tlb{};
+};
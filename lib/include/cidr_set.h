@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <boost/asio/ip/address_v4.hpp>
+#include "ip_prefix.h"
+
+/**
+ * @brief Набор CIDR префиксов с поиском наиболее длинного совпадающего префикса (DIR-24-8)
+ * @details Старшие 24 бита адреса индексируют таблицу tbl24 (2^24 записей). Запись хранит длину префикса
+ * или, если под ней есть префиксы длиннее /24, номер группы из 256 записей в tbl8.
+ * Поиск - одно или два обращения к памяти, O(1)
+ */
+class CidrSet {
+public:
+    /// Пустой набор
+    CidrSet();
+
+    /**
+     * @brief Конструктор. Построить набор из префиксов
+     * @param prefixes Префиксы
+     */
+    explicit CidrSet(std::vector<IpPrefix> prefixes);
+
+    /**
+     * @brief Загрузка префиксов из файла
+     * @details Строка файла: "a.b.c.d/len" или "a.b.c.d" (/32). Пустые строки и строки с '#' пропускаются,
+     * невалидные строки пропускаются и учитываются в Rejected()
+     * @param file Путь до файла
+     * @return
+     * true - Файл прочитан
+     * false - Ошибка чтения файла
+     */
+    [[nodiscard]] bool Load(std::string const &file);
+
+    /**
+     * @brief Построить набор заново
+     * @param prefixes Префиксы
+     */
+    void Build(std::vector<IpPrefix> prefixes);
+
+    /**
+     * @brief Поиск наиболее длинного префикса
+     * @param ip Адрес в порядке байт хоста
+     * @return Длина найденного префикса (1..32, для /0 возвращается 1) или 0, если адрес не входит в набор
+     */
+    [[nodiscard]] uint8_t Lookup(uint32_t const ip) const {
+        uint32_t const entry{tbl24[ip >> kTbl8Bits]};
+        return resolve(entry, ip);
+    }
+
+    /**
+     * @brief Поиск для контейнера адресов
+     * @details Записи tbl24 читаются пачками по kBatchSize независимых загрузок,
+     * чтобы промахи кэша перекрывались
+     * @param ips Адреса в порядке байт хоста
+     * @param out Длины найденных префиксов, размер не меньше ips.size()
+     */
+    void LookupBatch(std::span<uint32_t const> ips, std::span<uint8_t> out) const;
+
+    bool operator()(uint32_t const ip) const {
+        return Lookup(ip) != 0;
+    }
+
+    bool operator()(boost::asio::ip::address_v4 const &ip) const {
+        return Lookup(ip.to_uint()) != 0;
+    }
+
+    /// Количество префиксов в наборе
+    [[nodiscard]] size_t Size() const;
+
+    /// Количество невалидных строк при загрузке из файла
+    [[nodiscard]] size_t Rejected() const;
+
+private:
+    static constexpr int kTbl8Bits{8};
+    static constexpr uint32_t kTbl8Size{1u << kTbl8Bits};
+    static constexpr uint32_t kTbl8Mask{kTbl8Size - 1};
+    /// Признак записи tbl24, ссылающейся на группу tbl8
+    static constexpr uint32_t kExtended{0x80000000};
+    static constexpr size_t kBatchSize{8};
+
+    [[nodiscard]] uint8_t resolve(uint32_t const entry, uint32_t const ip) const {
+        if (entry & kExtended) {
+            return tbl8[(entry & ~kExtended) << kTbl8Bits | (ip & kTbl8Mask)];
+        }
+        return static_cast<uint8_t>(entry);
+    }
+
+    /// Добавить префикс. Префиксы добавляются по возрастанию длины
+    void insert(IpPrefix const &prefix);
+
+    /// Таблица старших 24 бит
+    std::vector<uint32_t> tbl24{};
+    /// Группы по 256 записей для префиксов длиннее /24
+    std::vector<uint8_t> tbl8{};
+    /// Количество префиксов
+    size_t size{};
+    /// Количество невалидных строк
+    size_t rejected{};
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Буфер потока, распаковывающий сжатые данные в памяти (gzip, zstd)
+ * @details Сжатые данные обычно берутся из отображенного в память файла. Распаковка идет по мере чтения:
+ * std::istream::read распаковывает сразу в буфер вызывающего без промежуточной копии, поэтому распакованный
+ * текст целиком не хранится. gzip поддерживается при сборке с zlib (IP_FILTER_WITH_ZLIB), zstd - с libzstd
+ * (IP_FILTER_WITH_ZSTD). Несколько gzip членов или zstd кадров подряд читаются как один поток
+ */
+class DecompressBuf : public std::streambuf {
+public:
+    /// Формат данных
+    enum class Format : uint8_t {
+        /// Несжатые данные
+        kPlain,
+        kGzip,
+        kZstd,
+    };
+
+    /**
+     * @brief Формат по сигнатуре в начале данных
+     * @param data Данные или их начало
+     */
+    [[nodiscard]] static Format Detect(std::string_view data);
+
+    /// Формат поддержан сборкой
+    [[nodiscard]] static bool Supported(Format format);
+
+    /**
+     * @brief Границы zstd кадров
+     * @details Кадры независимы и могут распаковываться параллельно
+     * @param data Сжатые данные
+     * @return Кадры по порядку; пусто, если сборка без zstd или данные повреждены
+     */
+    [[nodiscard]] static std::vector<std::string_view> ZstdFrames(std::string_view data);
+
+    /**
+     * @brief Конструктор
+     * @param compressed Сжатые данные, должны существовать, пока читается буфер
+     * @param format Формат данных, kPlain - данные передаются как есть
+     */
+    DecompressBuf(std::string_view compressed, Format format);
+
+    ~DecompressBuf() override;
+
+    DecompressBuf(DecompressBuf const &) = delete;
+
+    DecompressBuf &operator=(DecompressBuf const &) = delete;
+
+    /// Ошибок распаковки не было: данные не повреждены и не обрезаны, формат поддержан
+    [[nodiscard]] bool Good() const;
+
+protected:
+    int_type underflow() override;
+
+    std::streamsize xsgetn(char *out, std::streamsize size) override;
+
+private:
+    /// Размер буфера для посимвольного чтения (underflow)
+    static constexpr size_t kBufferSize{1 << 16};
+
+    /**
+     * @brief Распаковать следующую часть данных
+     * @param out Буфер
+     * @param size Размер буфера
+     * @return Количество байт, 0 - конец данных или ошибка
+     */
+    size_t decode(char *out, size_t size);
+
+    size_t decodeGzip(char *out, size_t size);
+
+    size_t decodeZstd(char *out, size_t size);
+
+    /// Сжатые данные
+    std::string_view const input;
+    Format const format;
+    /// Количество переданных распаковщику байт сжатых данных
+    size_t consumed{};
+    /// Состояние распаковщика: z_stream или ZSTD_DCtx
+    void *state{};
+    /// Буфер для underflow
+    std::vector<char> buffer{};
+    /// Данные закончились
+    bool finished{};
+    /// Ошибка распаковки
+    bool error{};
+};
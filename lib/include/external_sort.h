@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Временный файл упакованных ip адресов (uint32_t)
+ * @details Файл создается через std::tmpfile() и удаляется при закрытии. Буфер записи выделяется при первой
+ * записи адреса и освобождается в Rewind(), поэтому записанный файл память не занимает
+ */
+class SpillFile {
+public:
+    SpillFile();
+
+    /// Файл создан и ошибок записи не было
+    [[nodiscard]] bool Good() const;
+
+    /**
+     * @brief Запись ip адреса
+     * @param ip Адрес в порядке байт хоста
+     */
+    void Write(uint32_t const ip) {
+        if (buffer.size() == buffer.capacity()) {
+            flush();
+            buffer.reserve(kBufferSize);
+        }
+        buffer.push_back(ip);
+    }
+
+    /**
+     * @brief Запись ip адресов
+     * @param ips Адреса в порядке байт хоста
+     */
+    void Write(std::span<uint32_t const> ips);
+
+    /// Завершить запись, освободить буфер и перейти к чтению с начала файла
+    void Rewind();
+
+    /// Количество записанных адресов
+    [[nodiscard]] size_t Size() const;
+
+    /**
+     * @brief Чтение ip адресов
+     * @param out Буфер
+     * @return Количество прочитанных адресов, 0 - конец файла
+     */
+    size_t Read(std::span<uint32_t> out);
+
+    /**
+     * @brief Чтение ip адресов с позиции
+     * @param offset Номер первого адреса в файле
+     * @param out Буфер
+     * @return Количество прочитанных адресов, 0 - конец файла или ошибка позиционирования (Good() == false)
+     */
+    size_t Read(size_t offset, std::span<uint32_t> out);
+
+    /**
+     * @brief Чтение всех ip адресов
+     * @tparam Func Тип функции обработки адреса
+     * @param func Функция обработки адреса
+     */
+    template<class Func>
+    void ForEach(Func &&func) {
+        Rewind();
+        buffer.resize(kBufferSize);
+        for (size_t size{}; (size = Read(buffer)) != 0;) {
+            for (size_t i{}; i < size; ++i) {
+                func(buffer[i]);
+            }
+        }
+        buffer = {};
+    }
+
+private:
+    /// Размер буфера в адресах
+    static constexpr size_t kBufferSize{1 << 14};
+
+    void flush();
+
+    /// Закрытие временного файла
+    struct Closer {
+        void operator()(std::FILE *const file) const {
+            std::fclose(file);
+        }
+    };
+
+    /// Временный файл
+    std::unique_ptr<std::FILE, Closer> file;
+    /// Буфер записи
+    std::vector<uint32_t> buffer{};
+    /// Количество записанных адресов
+    size_t size{};
+    /// Ошибка создания файла или записи
+    bool failed{};
+};
+
+/**
+ * @brief Сортировка ip адресов по убыванию с ограничением памяти
+ * @details Адреса накапливаются в серии размером max_memory / 8 (место для поразрядной сортировки),
+ * отсортированные серии дописываются в один временный файл (SpillFile). Finish() сливает серии группами
+ * не больше kMaxFanIn в новый файл, пока серий больше kMaxFanIn, затем Next() выдает адреса по одному
+ * k-путевым слиянием оставшихся серий. Буферы чтения серий делят max_memory, открыто не больше двух файлов.
+ * Если все адреса поместились в одну серию, файлы не создаются
+ */
+class ExternalSort {
+public:
+    /**
+     * @brief Конструктор
+     * @param max_memory Ограничение памяти в байтах
+     */
+    explicit ExternalSort(size_t max_memory);
+
+    /**
+     * @brief Добавить ip адрес
+     * @param ip Адрес в порядке байт хоста
+     */
+    void Push(uint32_t const ip) {
+        run.push_back(ip);
+        if (run.size() == run_size) {
+            spill();
+        }
+    }
+
+    /// Завершить добавление адресов и подготовить слияние
+    void Finish();
+
+    /**
+     * @brief Следующий адрес в порядке убывания
+     * @param ip Адрес
+     * @return
+     * true - Адрес получен
+     * false - Адреса закончились
+     */
+    [[nodiscard]] bool Next(uint32_t &ip);
+
+    /// Временные файлы созданы и записаны без ошибок
+    [[nodiscard]] bool Good() const;
+
+    /// Количество серий, сброшенных во временный файл
+    [[nodiscard]] size_t NumRuns() const;
+
+    /// Количество промежуточных проходов слияния в Finish()
+    [[nodiscard]] size_t NumPasses() const;
+
+    /// Наибольшее количество серий в одном слиянии
+    static constexpr size_t kMaxFanIn{64};
+
+private:
+    /// Минимальный размер серии и буфера чтения в адресах
+    static constexpr size_t kMinBufferSize{1 << 8};
+
+    /// Серия во временном файле и ее буфер чтения
+    struct Cursor {
+        /// Номер следующего непрочитанного адреса в файле
+        size_t offset{};
+        /// Номер адреса после конца серии
+        size_t end{};
+        /// Позиция в буфере
+        size_t pos{};
+        /// Количество адресов в буфере
+        size_t size{};
+    };
+
+    /// Отсортировать текущую серию и дописать во временный файл
+    void spill();
+
+    /// Подготовить слияние серий [first, last) файла file
+    void startMerge(size_t first, size_t last);
+
+    /// Следующий адрес слияния, false - серии закончились
+    bool pop(uint32_t &ip);
+
+    /// Прочитать следующий блок серии, false - серия закончилась
+    bool refill(size_t index);
+
+    /// Ограничение памяти в байтах
+    size_t const max_memory;
+    /// Размер серии в адресах
+    size_t const run_size;
+    /// Текущая серия
+    std::vector<uint32_t> run{};
+    /// Временный файл серий, создается при первом сбросе
+    std::unique_ptr<SpillFile> file{};
+    /// Границы серий в файле: (номер первого адреса, количество адресов)
+    std::vector<std::pair<size_t, size_t> > bounds{};
+    /// Серии текущего слияния
+    std::vector<Cursor> cursors{};
+    /// Буферы чтения серий текущего слияния
+    std::vector<std::vector<uint32_t> > buffers{};
+    /// Куча слияния: (адрес, номер серии)
+    std::vector<std::pair<uint32_t, size_t> > heap{};
+    /// Количество сброшенных серий
+    size_t num_runs{};
+    /// Количество промежуточных проходов слияния
+    size_t num_passes{};
+    /// Позиция в текущей серии, если файлов нет
+    size_t run_pos{};
+    bool good{true};
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ip_parser.h"
+#include "ip_prefix.h"
+
+/**
+ * @brief Суммирование счетчиков входного файла по адресу или префиксу
+ * @details Строка входного файла: "a.b.c.d\trequests\tbytes". Счетчики суммируются по префиксу длины /8, /16, /24
+ * или по адресу (/32) в хеш-таблице с открытой адресацией (линейное пробирование, размер - степень двойки).
+ * Ключ - адрес префикса, поэтому таблица не больше числа разных префиксов во входных данных
+ */
+class IpAggregator {
+public:
+    /// Суммы счетчиков префикса
+    struct Entry {
+        /// Префикс
+        IpPrefix prefix{};
+        /// Сумма первого счетчика строки (запросы)
+        uint64_t requests{};
+        /// Сумма второго счетчика строки (байты)
+        uint64_t bytes{};
+    };
+
+    /**
+     * @brief Конструктор
+     * @param prefix_length Длина префикса агрегации: 8, 16, 24 или 32
+     */
+    explicit IpAggregator(int prefix_length = kAddressLength);
+
+    /**
+     * @brief Добавить строку входного файла
+     * @details Строки с невалидным адресом или счетчиками пропускаются и учитываются в Rejected()
+     * @param line Строка входного файла
+     * @return true - Строка учтена
+     */
+    bool AddLine(std::string_view line);
+
+    /**
+     * @brief Добавить строку входного файла, адрес которой уже разобран
+     * @details Первое поле повторно не разбирается, разбираются только счетчики
+     * @param line Строка входного файла
+     * @param status Результат разбора первого поля строки
+     * @param ip Адрес строки, используется только при Status::kOk
+     * @return true - Строка учтена
+     */
+    bool AddLine(std::string_view line, IpParser::Status status, uint32_t ip);
+
+    /**
+     * @brief Добавить счетчики адреса
+     * @param ip Адрес в порядке байт хоста
+     * @param requests Первый счетчик
+     * @param bytes Второй счетчик
+     */
+    void Add(uint32_t ip, uint64_t requests, uint64_t bytes);
+
+    /**
+     * @brief Добавить суммы другой агрегации с той же длиной префикса
+     * @param other Агрегация, например, части файла из другого потока
+     */
+    void Merge(IpAggregator const &other);
+
+    /**
+     * @brief Префиксы с наибольшими суммами
+     * @details Порядок: по убыванию requests, затем bytes, затем адреса префикса
+     * @param num Количество префиксов
+     * @return Не больше num префиксов
+     */
+    [[nodiscard]] std::vector<Entry> Top(size_t num) const;
+
+    /**
+     * @brief Строка результата: "a.b.c.d/len\trequests\tbytes"
+     * @param entry Суммы префикса
+     */
+    [[nodiscard]] static std::string Format(Entry const &entry);
+
+    /// Длина префикса агрегации
+    [[nodiscard]] int PrefixLength() const;
+
+    /// Количество разных префиксов
+    [[nodiscard]] size_t Size() const;
+
+    /// Количество пропущенных строк
+    [[nodiscard]] size_t Rejected() const;
+
+    /// Длина префикса агрегации по адресу
+    static constexpr int kAddressLength{32};
+
+private:
+    /// Начальный размер таблицы
+    static constexpr size_t kMinCapacity{1 << 10};
+
+    /// Ячейка таблицы
+    struct Slot {
+        uint32_t key{};
+        bool used{};
+        uint64_t requests{};
+        uint64_t bytes{};
+    };
+
+    /// Ячейка ключа: найденная или пустая, в которую ключ будет добавлен
+    Slot &find(uint32_t key);
+
+    /// Увеличить таблицу в 2 раза
+    void grow();
+
+    /// Маска префикса
+    uint32_t mask{};
+    /// Длина префикса
+    int prefix_length{};
+    /// Таблица
+    std::vector<Slot> slots;
+    /// Количество занятых ячеек
+    size_t size{};
+    /// Количество пропущенных строк
+    size_t rejected{};
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Множество ip адресов в виде битовой карты всего пространства IPv4
+ * @details Пространство 2^32 адресов делится на 2^16 блоков по 2^16 бит (8 КБ), блок выделяется при первой
+ * вставке адреса из него, поэтому биты занимают 8 КБ на занятый блок (не больше 512 МБ).
+ * Обход битов от старших к младшим дает адреса по убыванию без удаления повторов и без сортировки сравнением.
+ * В режиме подсчета кратность хранится только для повторяющихся адресов, в хеш-таблице повторов,
+ * поэтому она добавляет память пропорционально числу разных повторяющихся адресов
+ */
+class IpBitmap {
+public:
+    /**
+     * @brief Конструктор
+     * @param counting Хранить кратность адресов
+     */
+    explicit IpBitmap(bool counting = false);
+
+    /**
+     * @brief Добавить ip адрес
+     * @param ip Адрес в порядке байт хоста
+     */
+    void Insert(uint32_t const ip) {
+        auto &block{blocks[ip >> kBlockBits]};
+        if (!block) {
+            block = allocate();
+        }
+        uint32_t const low{ip & kLowMask};
+        uint64_t &word{block->bits[low / kWordBits]};
+        uint64_t const bit{uint64_t{1} << (low % kWordBits)};
+        if ((word & bit) == 0) {
+            word |= bit;
+            ++num_unique;
+        } else if (counting) {
+            ++repeats[ip];
+        }
+        ++num_total;
+    }
+
+    /**
+     * @brief Среднее число адресов на занятый блок
+     * @details Оценка плотности адресов до вставки: по ней видно, займет ли битовая карта меньше памяти,
+     * чем контейнер адресов
+     * @param ips Адреса в порядке байт хоста
+     * @return Количество адресов на один занятый блок, 0 - адресов нет
+     */
+    [[nodiscard]] static size_t Density(std::span<uint32_t const> ips);
+
+    /// Память битов одного блока в байтах
+    static constexpr size_t kBlockBytes{(size_t{1} << 16) / 8};
+
+    /**
+     * @brief Кратность ip адреса
+     * @details Без режима подсчета возвращает 0 или 1
+     * @param ip Адрес в порядке байт хоста
+     */
+    [[nodiscard]] uint32_t Count(uint32_t ip) const;
+
+    /// ip адрес есть в множестве
+    [[nodiscard]] bool Contains(uint32_t ip) const;
+
+    /// Количество добавленных адресов с повторами
+    [[nodiscard]] size_t Size() const;
+
+    /// Количество разных адресов
+    [[nodiscard]] size_t Unique() const;
+
+    /// Хранится кратность адресов
+    [[nodiscard]] bool Counting() const;
+
+    /**
+     * @brief Обход адресов диапазона [first, last] по убыванию
+     * @details Просматриваются только слова битовой карты, попадающие в диапазон
+     * @tparam Func Тип функции обработки адреса
+     * @param first Первый адрес диапазона
+     * @param last Последний адрес диапазона
+     * @param func Функция обработки: (uint32_t ip, uint32_t count), без режима подсчета count равен 1
+     */
+    template<class Func>
+    void ForEachDescending(uint32_t const first, uint32_t const last, Func &&func) const {
+        for (uint32_t hi{last >> kBlockBits}; ; --hi) {
+            if (auto const &block{blocks[hi]}; block) {
+                uint32_t const lo_first{hi == first >> kBlockBits ? first & kLowMask : 0};
+                uint32_t const lo_last{hi == last >> kBlockBits ? last & kLowMask : kLowMask};
+                walkBlock(hi, *block, lo_first, lo_last, func);
+            }
+            if (hi == first >> kBlockBits) {
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Обход всех адресов по убыванию
+     * @tparam Func Тип функции обработки адреса
+     * @param func Функция обработки: (uint32_t ip, uint32_t count)
+     */
+    template<class Func>
+    void ForEachDescending(Func &&func) const {
+        ForEachDescending(0, ~uint32_t{}, func);
+    }
+
+    /**
+     * @brief Обход адресов, у которых хотя бы один октет равен octet, по убыванию
+     * @details Если octet есть в двух старших октетах, блок обходится целиком. Иначе в блоке обходятся
+     * 4 слова третьего октета и проверяется один бит младшего октета в каждой группе из 256 адресов
+     * @tparam Func Тип функции обработки адреса
+     * @param octet Значение октета
+     * @param func Функция обработки: (uint32_t ip, uint32_t count)
+     */
+    template<class Func>
+    void ForEachAnyOctetDescending(uint8_t const octet, Func &&func) const {
+        static constexpr uint32_t kOctetMask{0xFF};
+        static constexpr uint32_t kOctetBits{8};
+        static constexpr uint32_t kNumGroups{1 << kOctetBits};
+
+        for (uint32_t hi{kNumBlocks}; hi-- != 0;) {
+            auto const &block{blocks[hi]};
+            if (!block) {
+                continue;
+            }
+            if ((hi >> kOctetBits) == octet || (hi & kOctetMask) == octet) {
+                walkBlock(hi, *block, 0, kLowMask, func);
+                continue;
+            }
+            for (uint32_t group{kNumGroups}; group-- != 0;) {
+                if (group == octet) {
+                    walkBlock(hi, *block, group << kOctetBits, group << kOctetBits | kOctetMask, func);
+                } else if (uint32_t const low{group << kOctetBits | octet}; test(*block, low)) {
+                    func(hi << kBlockBits | low, count(hi << kBlockBits | low));
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t kBlockBits{16};
+    static constexpr uint32_t kNumBlocks{1 << kBlockBits};
+    static constexpr uint32_t kLowMask{kNumBlocks - 1};
+    static constexpr uint32_t kWordBits{64};
+    static constexpr uint32_t kNumWords{kNumBlocks / kWordBits};
+
+    /// Блок из 2^16 адресов
+    struct Block {
+        std::array<uint64_t, kNumWords> bits{};
+    };
+    static_assert(sizeof(Block) == kBlockBytes);
+
+    /// Выделить блок
+    [[nodiscard]] static std::unique_ptr<Block> allocate();
+
+    /// Адрес блока есть в множестве
+    static bool test(Block const &block, uint32_t const low) {
+        return (block.bits[low / kWordBits] >> (low % kWordBits) & 1) != 0;
+    }
+
+    /// Кратность адреса, который есть в множестве
+    [[nodiscard]] uint32_t count(uint32_t ip) const;
+
+    /// Обход адресов блока в диапазоне младших бит [lo_first, lo_last] по убыванию
+    template<class Func>
+    void walkBlock(uint32_t const hi, Block const &block, uint32_t const lo_first, uint32_t const lo_last,
+                   Func &func) const {
+        uint32_t const word_first{lo_first / kWordBits};
+        uint32_t const word_last{lo_last / kWordBits};
+        for (uint32_t w{word_last + 1}; w-- != word_first;) {
+            uint64_t bits{block.bits[w]};
+            if (w == word_last) {
+                bits &= ~uint64_t{} >> (kWordBits - 1 - lo_last % kWordBits);
+            }
+            if (w == word_first) {
+                bits &= ~uint64_t{} << (lo_first % kWordBits);
+            }
+            while (bits != 0) {
+                int const bit{std::countl_zero(bits) ^ static_cast<int>(kWordBits - 1)};
+                bits ^= uint64_t{1} << bit;
+                uint32_t const ip{hi << kBlockBits | w * kWordBits | static_cast<uint32_t>(bit)};
+                func(ip, count(ip));
+            }
+        }
+    }
+
+    /// Блоки битовой карты
+    std::vector<std::unique_ptr<Block> > blocks;
+    /// Повторы адресов в режиме подсчета: кратность минус 1, только для адресов с кратностью больше 1
+    std::unordered_map<uint32_t, uint32_t> repeats{};
+    /// Количество добавленных адресов
+    size_t num_total{};
+    /// Количество разных адресов
+    size_t num_unique{};
+    /// Режим подсчета
+    bool counting{};
+};
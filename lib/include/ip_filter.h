@@ -1,6 +1,7 @@
 #pragma once
 
 #include <format>
+#include <functional>
 #include <ranges>
 #include <vector>
 #include <iostream>
@@ -8,44 +9,47 @@
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
+#include "arena.h"
+#include "cidr_set.h"
+#include "decompress_buf.h"
+#include "ip_aggregator.h"
+#include "ip_bitmap.h"
+#include "ip_index.h"
+#include "ip_parser.h"
+#include "ip_predicates.h"
+#include "ip_prefix.h"
+#include "ip_runs.h"
+#include "ip_stats.h"
+#include "ip_writer.h"
+#include "mapped_file.h"
+#include "radix_sort.h"
+#include "rule_set.h"
+#include "top_k.h"
 #include "version.h"
 
 namespace Otus {
-    static constexpr bool task_1(boost::asio::ip::address_v4 const &) {
-        return true;
-    }
+    using IpMatch::kAny;
 
-    static constexpr auto task_2{
-        [](boost::asio::ip::address_v4 const &ip) {
-            static constexpr int kFirstByte{3};
+    /// Все адреса. Префикс /0
+    static constexpr IpMatch::Octets<kAny, kAny, kAny, kAny> task_1{};
 
-            auto const raw_ip{ip.to_uint()};
-            uint8_t const *raw{reinterpret_cast<uint8_t const *>(&raw_ip)};
-            std::span<uint8_t const> const ptr_raw_ip{raw, sizeof(uint32_t)};
-            return ptr_raw_ip[kFirstByte] == 1;
-        }
-    };
+    /// Первый октет равен 1. Адреса образуют один диапазон в отсортированном контейнере
+    static constexpr IpMatch::Octets<1, kAny, kAny, kAny> task_2{};
 
-    static constexpr auto task_3{
-        [](boost::asio::ip::address_v4 const &ip) {
-            static constexpr int kFirstByte{3};
-            static constexpr int kSecondByte{2};
+    /// Первый октет равен 46, второй октет равен 70
+    static constexpr IpMatch::Octets<46, 70, kAny, kAny> task_3{};
 
-            auto raw_ip{ip.to_uint()};
-            uint8_t const *raw{reinterpret_cast<uint8_t const *>(&raw_ip)};
-            std::span<uint8_t const> const ptr_raw_ip{raw, sizeof(uint32_t)};
-            return ptr_raw_ip[kFirstByte] == 46 && ptr_raw_ip[kSecondByte] == 70;
-        }
-    };
-
-    static constexpr auto task_4{
-        [](boost::asio::ip::address_v4 const &ip) {
-            auto raw_ip{ip.to_uint()};
-            uint8_t const *raw{reinterpret_cast<uint8_t const *>(&raw_ip)};
-            std::span<uint8_t const> const ptr_raw_ip{raw, sizeof(uint32_t)};
-            return std::ranges::find(ptr_raw_ip, 46) != ptr_raw_ip.end();
-        }
-    };
+    /// Хотя бы один октет равен 46
+    static constexpr IpMatch::AnyOctet<46> task_4{};
 }
 
 /**
@@ -54,54 +58,28 @@ namespace Otus {
 class RangesFuncs {
 protected:
     /// Тип данных. Информация об ip адресе после конвретации из строки
-    using ip_info_t = std::tuple<boost::asio::ip::address_v4, boost::system::error_code>;
-
-    /**
-     * @brief Проверка валидности строки ip адреса
-     * @details Максимальное значение = 15 байтам (строка "255.255.255.255")
-     */
-    static constexpr auto is_valid_size{
-        [](auto &&rng) {
-            static constexpr int kMaxNumLenIpStr{15};
-
-            return std::ranges::distance(rng) <= kMaxNumLenIpStr;
-        }
-    };
-
-    /**
-     * @brief Проверка количества точек в строке ip адерса
-     * @details В ip адресе должно быть 3 точки (строка "255.255.255.255")
-     * В Linux ip адрес 255.255.255 - не валиден
-     * В Windows ip адрес 255.255.255 - валиден и был преобразован 255.255.0.255
-     */
-    static constexpr auto is_valid_num_points{
-        [](auto &&rng) {
-            static constexpr int kNumPoints{3};
-
-            return std::ranges::count(rng, '.') == kNumPoints;
-        }
-    };
+    using ip_info_t = std::tuple<boost::asio::ip::address_v4, IpParser::Status>;
 
     /**
      * @brief Конвертация ip адреса строки в boost::asio::ip::address_v4 и состояние валидности ip адреса
+     * @details Проверки длины строки, количества точек и значений октетов выполняет IpParser::Parse
      */
     static constexpr auto convert_to_ip{
         [](auto &&rng) {
-            boost::system::error_code ec{};
-            std::string const str{std::ranges::cbegin(rng), std::ranges::cend(rng)};
-            auto const address{boost::asio::ip::address_v4::from_string(str, ec)};
-            return ip_info_t{address, ec};
+            uint32_t raw_ip{};
+            auto const status{IpParser::Parse(std::string_view{std::ranges::data(rng), std::ranges::size(rng)}, raw_ip)};
+            return ip_info_t{boost::asio::ip::address_v4{raw_ip}, status};
         }
     };
 
     /**
-     * @brief Проверка валидности ip адреса по error code полученному при конвертации ip адреса
+     * @brief Проверка валидности ip адреса по состоянию, полученному при конвертации ip адреса
      */
     static constexpr auto is_valid_ip{
         [](ip_info_t const &ip) {
-            static constexpr int kErrorCode{1};
+            static constexpr int kStatus{1};
 
-            return !std::get<kErrorCode>(ip);
+            return std::get<kStatus>(ip) == IpParser::Status::kOk;
         }
     };
 
@@ -116,6 +94,16 @@ protected:
             return std::get<kIp>(ip_info);
         }
     };
+
+    /**
+     * @brief Адрес boost::asio::ip::address_v4 из упакованного адреса
+     * @details Текст адреса формируется только при выводе
+     */
+    static constexpr auto to_address{
+        [](uint32_t const ip) {
+            return boost::asio::ip::address_v4{ip};
+        }
+    };
 };
 
 /**
@@ -123,11 +111,39 @@ protected:
  */
 class IpFilter : RangesFuncs {
 public:
+    /// Хранилище адресов
+    enum class Storage : uint8_t {
+        /// Контейнер адресов с поразрядной сортировкой
+        kVector,
+        /// Битовая карта пространства IPv4 (IpBitmap), сортировка не нужна
+        kBitmap,
+        /// Контейнер; с SetUnique() после парсинга битовая карта, если адреса плотные (kBitmapMinDensity)
+        kAuto,
+    };
+
+    /// Секция вывода: фильтр, которому соответствует выведенный адрес
+    enum class Section : uint8_t {
+        kTask1,
+        kTask2,
+        kTask3,
+        kTask4,
+        /// Набор CIDR префиксов LoadCidrFile()
+        kCidr,
+    };
+
+    /// Получатель выведенных адресов вместо выходного файла: (секция, адрес в порядке байт хоста)
+    using Sink = std::function<void(Section, uint32_t)>;
+
+    /// Наибольшее количество потоков SetThreads(): каждый поток конвейера держит kPipelineBlocks блоков чтения
+    static constexpr unsigned kMaxThreads{256};
+
     /**
      * @brief Конструктор. Сохранить путь входного файла
      * @param file Путь до входного файла
+     * @param resource Ресурс памяти контейнеров адресов и временных частей файла, например, HugePageResource
      */
-    explicit IpFilter(std::string file, std::string const &out = "", int const standart = 17);
+    explicit IpFilter(std::string file, std::string const &out = "", int const standart = 17,
+                      std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
     explicit IpFilter() = default;
 
@@ -135,25 +151,227 @@ public:
      * @brief Парсинг ip строк
      * @return
      * true - Парсинг без ошибок
-     * false - Ошибка при парсинге
+     * false - Ошибка при парсинге или записи вывода
      */
     [[nodiscard]] bool Parsing();
 
     /**
      * @brief Парсинг контейнера строк
-     * @details Используется для тестов и применим для 23 стандарта
+     * @details Используется для тестов и применим для 23 стандарта. Для встраивания без строки на каждую
+     * входную строку - Feed() и Finish()
      * @param in Контенер строк
      */
     void ParsingInputVector(std::vector<std::string> const &in);
 
+    /**
+     * @brief Передать очередную часть входных данных
+     * @details Строки разбираются на месте, без копирования в строки и без выделения памяти на строку.
+     * Строка, разрезанная границей частей, дописывается в буфер неполной строки и разбирается, когда приходит
+     * ее конец. Первый Feed() после Finish() (или после создания) начинает новый набор адресов. Данные части
+     * после возврата не используются. Входной файл, хранилище, снимок, SetLimit() и ограничение памяти
+     * не используются
+     * @param chunk Часть данных, например приемный буфер сокета
+     */
+    void Feed(std::span<char const> chunk);
+
+    /**
+     * @brief Завершить ввод Feed()
+     * @details Разбирает последнюю строку без '\n', сортирует адреса и выводит результаты фильтров, набора CIDR
+     * префиксов, правил и агрегации так же, как Parsing() для контейнера. Адреса передаются получателю
+     * SetSink(), если он задан, иначе в выходной файл или std::cout. Статистика доступна через Stats()
+     * @return true - Результаты выведены без ошибок записи
+     */
+    [[nodiscard]] bool Finish();
+
+    /**
+     * @brief Получатель выведенных адресов
+     * @details Если задан, адреса фильтров и набора CIDR префиксов из Parsing(), Follow() и Finish() передаются
+     * ему вместо выходного файла, с секцией вывода. Строки агрегации и потоки правил выводятся как обычно
+     * @param output Получатель, пустая функция - вывод в выходной файл или std::cout
+     */
+    void SetSink(Sink output);
+
     /**
      * @brief Сортировка контейнера ip адресов получнных после парсинга входного файла
+     * @details Для std::greater используется поразрядная сортировка (RadixSort) в SetThreads() потоках,
+     * иначе сортировка сравнением адресов boost::asio::ip::address_v4
+     * @tparam Compare Тип функции сортировки
      * @param func Функция сортировки
      */
-    void Sorting(std::function<bool(boost::asio::ip::address_v4 const &, boost::asio::ip::address_v4 const &)> func);
+    template<class Compare>
+    void Sorting(Compare func) {
+        using ip_t = boost::asio::ip::address_v4;
+
+        if constexpr (std::is_same_v<Compare, std::greater<> > || std::is_same_v<Compare, std::greater<ip_t> >) {
+            RadixSort::Descending(ips, std::identity{}, threads);
+            sorted_descending = true;
+        } else {
+            std::ranges::sort(ips, func, to_address);
+            sorted_descending = false;
+        }
+    }
+
+    /**
+     * @brief Загрузка набора CIDR префиксов
+     * @details Если набор загружен, то после фильтров Otus выводятся ip адреса, входящие в набор
+     * @param cidr_file Путь до файла префиксов (см. CidrSet::Load)
+     * @return
+     * true - Файл прочитан
+     * false - Ошибка чтения файла
+     */
+    [[nodiscard]] bool LoadCidrFile(std::string const &cidr_file);
+
+    /**
+     * @brief Загрузка правил по октетам
+     * @details Правила компилируются в таблицы по октетам (RuleSet). После фильтров и набора CIDR префиксов
+     * адреса проходятся один раз, и каждый адрес выводится в поток каждого совпавшего правила. Поток правила
+     * буферизирует kRuleBufferSize байт и открывает файл только на время сброса буфера, поэтому число правил
+     * не ограничено числом открытых файлов
+     * @param rules_file Путь до файла правил (см. RuleSet::Load)
+     * @return
+     * true - Файл прочитан, файлы вывода правил созданы
+     * false - Ошибка чтения файла или создания файла вывода правила, прежние правила сохраняются
+     */
+    [[nodiscard]] bool LoadRulesFile(std::string const &rules_file);
+
+    /**
+     * @brief Количество потоков парсинга входного файла и сортировки адресов
+     * @details Файл, отображенный в память, делится на части по строкам, поток ввода и сжатый файл разбираются
+     * конвейером. Контейнер адресов сортируется параллельной поразрядной сортировкой. Вывод не зависит
+     * от количества потоков
+     * @param num_threads Количество потоков, 0 и 1 - парсинг в вызывающем потоке, больше kMaxThreads - kMaxThreads
+     */
+    void SetThreads(unsigned num_threads);
 
-    /// Получить контейнер ip адресов после парсинга входных данных
-    [[nodiscard]] std::vector<boost::asio::ip::address_v4> GetIPs() const;
+    /// Количество потоков после SetThreads()
+    [[nodiscard]] unsigned Threads() const;
+
+    /**
+     * @brief Ограничение памяти для адресов
+     * @details Если задано, то адреса сортируются сериями во временных файлах и сливаются (ExternalSort),
+     * весь набор адресов не хранится в памяти. Вывод совпадает с выводом без ограничения
+     * @param bytes Ограничение в байтах, 0 - без ограничения
+     */
+    void SetMaxMemory(size_t bytes);
+
+    /**
+     * @brief Выбор хранилища адресов
+     * @details В битовой карте адреса хранятся без контейнера, парсинг выполняется в вызывающем потоке,
+     * GetIPs() возвращает пустое представление. Ограничение памяти (SetMaxMemory) имеет приоритет
+     * @param storage_kind Хранилище адресов
+     */
+    void SetStorage(Storage storage_kind);
+
+    /**
+     * @brief Вывод без повторов
+     * @details Без этого режима адрес выводится столько раз, сколько он встретился во входных данных
+     * @param unique_only Выводить каждый адрес один раз
+     */
+    void SetUnique(bool unique_only);
+
+    /**
+     * @brief Суммирование счетчиков входного файла по префиксу
+     * @details Счетчики разбираются в том же проходе по входному файлу, что и адреса (IpAggregator).
+     * После вывода фильтров выводятся top_n префиксов с наибольшими суммами
+     * @param prefix_length Длина префикса: 8, 16, 24 или 32 (по адресу)
+     * @param top_n Количество выводимых префиксов
+     */
+    void SetAggregation(int prefix_length, size_t top_n);
+
+    /**
+     * @brief Сбор счетчиков строк
+     * @details Время фаз, объем входных данных и совпадения фильтров собираются всегда: это несколько замеров
+     * на весь Parsing(). При включенном сборе строки дополнительно считаются по причинам отказа (IpParser::Status),
+     * а страницы отображенного файла загружаются отдельной фазой read. Без сбора обход строк не меняется
+     * @param enabled Считать строки
+     */
+    void SetStats(bool enabled);
+
+    /**
+     * @brief Вывод только top_n наибольших адресов каждого фильтра
+     * @details Фильтры, набор CIDR префиксов и правила проверяются при чтении строк, совпадения каждого
+     * копятся в своем TopK. Контейнер всех адресов не создается и не сортируется: память O(top_n) на фильтр.
+     * Строки читаются в вызывающем потоке, снимок, битовая карта и ограничение памяти не используются.
+     * Follow() выводит все адреса
+     * @param top_n Количество адресов, 0 - без ограничения
+     */
+    void SetLimit(size_t top_n);
+
+    /// Статистика последнего Parsing()
+    [[nodiscard]] IpStats const &Stats() const;
+
+    /**
+     * @brief Запись снимка отсортированных адресов (IpIndex)
+     * @details Снимок записывается после сортировки контейнера адресов, поэтому при Storage::kAuto
+     * используется контейнер, а при битовой карте и ограничении памяти снимок не записывается.
+     * Если снимок уже есть и исходный файл не изменился (размер и время изменения), то он загружается
+     * вместо парсинга, как при SetLoadIndex(). Без входного файла (std::cin) данные всегда разбираются,
+     * снимок перезаписывается
+     * @param index_file Путь до файла снимка, пустая строка - не записывать
+     */
+    void SetSaveIndex(std::string index_file);
+
+    /**
+     * @brief Загрузка снимка отсортированных адресов (IpIndex) вместо парсинга и сортировки
+     * @details Снимок отображается в память, фильтры работают по нему без копирования. Снимок не используется,
+     * если он поврежден, исходный файл изменился после записи снимка или задан SetAggregation() (снимок не
+     * хранит счетчики); тогда входной файл разбирается как обычно. Без входного файла (std::cin) снимок
+     * используется без проверки исходного файла
+     * @param index_file Путь до файла снимка, пустая строка - не загружать
+     */
+    void SetLoadIndex(std::string index_file);
+
+    /**
+     * @brief Непрерывная обработка потока строк
+     * @details Строки читаются до конца потока, адреса добавляются в инкрементальный индекс (IpRuns) без
+     * полной пересортировки. По запросу (RequestEmit() или каждые interval) выводятся результаты фильтров
+     * и агрегации по всем прочитанным адресам в том же формате, что и Parsing(). Запрос выполняется после
+     * следующей прочитанной строки (без ожидания ввода - Follow(int)), в конце потока результаты выводятся
+     * всегда, поэтому вывод для конечного потока без запросов совпадает с выводом Parsing(). Хранилище
+     * и потоки парсинга не используются
+     * @param src Поток строк, например std::cin
+     * @param interval Период вывода, 0 - только по запросу и в конце потока
+     * @return
+     * true - Поток прочитан до конца
+     * false - Ошибка чтения потока или записи вывода
+     */
+    [[nodiscard]] bool Follow(std::istream &src, std::chrono::milliseconds interval = {});
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+    /**
+     * @brief Непрерывная обработка строк из дескриптора файла
+     * @details Как Follow(std::istream &), но ввод ожидается poll() с таймаутом до следующего периодического
+     * вывода, а RequestEmit() будит ожидание через self-pipe. Поэтому запрос и период выполняются сразу,
+     * даже если новых строк нет
+     * @param fd Дескриптор, например STDIN_FILENO
+     * @param interval Период вывода, 0 - только по запросу и в конце ввода
+     * @return
+     * true - Ввод прочитан до конца
+     * false - Ошибка чтения или записи вывода
+     */
+    [[nodiscard]] bool Follow(int fd, std::chrono::milliseconds interval = {});
+#endif
+
+    /**
+     * @brief Запросить вывод результатов в Follow()
+     * @details Устанавливает атомарный признак и будит ожидание ввода Follow(int) записью в self-pipe,
+     * поэтому может вызываться из обработчика сигнала и из другого потока
+     */
+    void RequestEmit();
+
+    /**
+     * @brief Получить ip адреса после парсинга входных данных
+     * @details Представление без копирования: адреса boost::asio::ip::address_v4 создаются из упакованных
+     * при обращении. Действительно до следующего Parsing() или ParsingInputVector()
+     */
+    [[nodiscard]] auto GetIPs() const {
+        return addresses() | std::views::transform(to_address);
+    }
+
+    /// Упакованные ip адреса (порядок байт хоста) после парсинга входных данных, без копирования
+    [[nodiscard]] std::span<uint32_t const> GetPackedIPs() const {
+        return addresses();
+    }
 
     /// Версия патча
     static uint64_t Version();
@@ -179,76 +397,461 @@ private:
      */
     [[nodiscard]] bool parsingCxx17();
 
+    /**
+     * @brief Чтение и парсинг входных строк
+     * @details При threads > 1 отображенный в память файл делится на части по границам строк, каждая часть
+     * разбирается своим потоком в свой контейнер, затем контейнеры объединяются в исходном порядке.
+     * Файл, который нельзя отобразить (канал, std::cin), при threads > 1 читается конвейером readStream().
+     * Сжатый файл (gzip, zstd) распаковывается readCompressed(). Иначе строки читаются через forEachLine()
+     * @tparam Parse Тип функции парсинга строки
+     * @param parse Функция парсинга строки: (std::string_view line, std::pmr::vector<uint32_t> &ips) -> IpParser::Status
+     */
+    template<class Parse>
+    void readLines(Parse parse);
+
+    /// Часть входных данных, разобранная своим потоком
+    struct Part {
+        explicit Part(std::pmr::memory_resource *const resource) : ips{resource} {
+        }
+
+        /// Адреса части
+        std::pmr::vector<uint32_t> ips;
+        /// Суммы счетчиков части, если задан SetAggregation()
+        std::optional<IpAggregator> aggregator{};
+        /// Счетчики строк части
+        IpStats stats{};
+    };
+
+    /**
+     * @brief Добавить часть
+     * @param parts Части
+     * @param resource Ресурс памяти контейнера адресов части
+     */
+    void addPart(std::vector<Part> &parts, std::pmr::memory_resource *resource) const;
+
+    /// Объединить адреса, суммы счетчиков и счетчики строк частей
+    void mergeParts(std::vector<Part> &parts);
+
+    /**
+     * @brief Конвейерное чтение и парсинг потока
+     * @details Поток читается вызывающим потоком большими блоками (std::istream::read), блок обрезается по
+     * последнему переводу строки, остаток переносится в следующий блок. Блоки по кругу передаются threads
+     * рабочим потокам через очереди SpscQueue и возвращаются обратно после разбора. У каждого рабочего потока
+     * kPipelineBlocks блоков, поэтому чтение ждет разбора, когда все блоки заняты
+     * @tparam ParsePart Тип функции парсинга строки в часть
+     * @param src Входной поток
+     * @param num_workers Количество рабочих потоков
+     * @param parse_part Функция парсинга строки: (std::string_view line, Part &part)
+     */
+    template<class ParsePart>
+    void readStream(std::istream &src, size_t num_workers, ParsePart const &parse_part);
+
+    /**
+     * @brief Распаковка и парсинг сжатого файла
+     * @details Распаковка (DecompressBuf) идет в потоке чтения readStream(), разбор - в рабочих потоках,
+     * поэтому распаковка и парсинг перекрываются и при threads = 1. zstd файл из нескольких кадров при
+     * threads > 1 делится на группы кадров, каждая группа распаковывается и разбирается своим потоком,
+     * неполные строки на границах групп склеиваются после объединения потоков
+     * @tparam ParsePart Тип функции парсинга строки в часть
+     * @param compressed Сжатые данные отображенного файла
+     * @param format Формат сжатия
+     * @param parse_part Функция парсинга строки: (std::string_view line, Part &part)
+     */
+    template<class ParsePart>
+    void readCompressed(std::string_view compressed, DecompressBuf::Format format, ParsePart const &parse_part);
+
+    /// Неполные строки на краях потока: до первого и после последнего перевода строки
+    struct Edges {
+        std::string head{};
+        std::string tail{};
+        /// В потоке есть перевод строки, иначе весь поток в tail
+        bool has_newline{};
+        /// Прочитано байт
+        uint64_t bytes{};
+    };
+
+    /**
+     * @brief Обход строк потока блоками без std::getline
+     * @tparam Func Тип функции обработки строки
+     * @param src Входной поток
+     * @param keep_edges Не передавать func первую строку и остаток после последнего перевода строки,
+     * а вернуть их в Edges. Иначе передаются все строки, как в MappedFile::ForEachLine
+     * @param func Функция обработки строки, принимает std::string_view
+     */
+    template<class Func>
+    static Edges forEachStreamLine(std::istream &src, bool keep_edges, Func &&func);
+
+    /**
+     * @brief Обход входных строк
+     * @details Входной файл отображается в память и строки передаются без копирования.
+     * Если файл не удалось отобразить, то он читается через std::ifstream,
+     * а если файл не удалось открыть, то строки читаются из std::cin.
+     * Строки считаются в статистике функцией обработки по результату ее разбора (countLine())
+     * @tparam Func Тип функции обработки строки
+     * @param func Функция обработки строки, принимает std::string_view
+     */
+    template<class Func>
+    void forEachLine(Func &&func);
+
+    /// Учесть строку в статистике по результату разбора, если сбор включен (SetStats())
+    void countLine(IpStats &line_stats, IpParser::Status const status) const {
+        if (collect_stats) {
+            line_stats.Count(status);
+        }
+    }
+
+    /// Учесть размер отображенного файла и, при сборе статистики, загрузить его страницы (фаза read)
+    void prefault(MappedFile const &mapped);
+
+    /**
+     * @brief Вывод секции и количество выведенных в ней адресов
+     * @tparam Func Тип функции вывода
+     * @param output_section Секция вывода, в нее передаются адреса print() и ее счетчик совпадений
+     * @param func Функция вывода
+     */
+    template<class Func>
+    void counted(Section const output_section, Func &&func) {
+        section = output_section;
+        uint64_t const before{printed};
+        func();
+        matchesOf(output_section) = printed - before;
+    }
+
+    /// Счетчик совпадений секции
+    [[nodiscard]] uint64_t &matchesOf(Section output_section);
+
+    /// Разбор строки Feed()
+    void feedLine(std::string_view line);
+
+    /**
+     * @brief Вывод фильтров по отсортированному контейнеру
+     * @details Общий для parsingCxx17() и Finish(): фильтры Otus, набор CIDR префиксов, правила и агрегация
+     */
+    void filterSorted();
+
+    /**
+     * @brief Вывод фильтров стандарта 23 по отсортированному контейнеру
+     * @details Функции фильтрации через filter(): префиксы - двоичным поиском, остальные - блоками
+     */
+    void filterCxx23();
+
+    /**
+     * @brief Итоговые время и память для Stats()
+     * @param clock Замер всей обработки
+     * @param allocations Количество выделений памяти контейнеров до обработки
+     */
+    void finishStats(PhaseClock const &clock, uint64_t allocations);
+
+    /// Вывод префиксов с наибольшими суммами счетчиков, если задан SetAggregation()
+    void printAggregation();
+
+    /// Вывод и потоки правил записаны без ошибок (IpWriter::Good())
+    [[nodiscard]] bool written() const;
+
+    /// Адреса для фильтров: снимок или контейнер
+    [[nodiscard]] std::span<uint32_t const> addresses() const {
+        return indexed ? index.Addresses() : std::span<uint32_t const>{ips};
+    }
+
+    /**
+     * @brief Загрузка снимка SetLoadIndex() или SetSaveIndex()
+     * @return true - Снимок загружен и соответствует исходному файлу, парсинг не нужен
+     */
+    [[nodiscard]] bool loadIndex();
+
+    /**
+     * @brief Фильтрация адресов загруженного снимка
+     * @return true - Файл был удачно обработан
+     */
+    [[nodiscard]] bool parsingIndex();
+
+    /**
+     * @brief Запись снимка SetSaveIndex() из отсортированного контейнера
+     * @return
+     * true - Снимок записан или не задан
+     * false - Ошибка записи
+     */
+    [[nodiscard]] bool saveIndex();
+
+    /// Разбор строки Follow(): адрес в индекс, строка в статистику и агрегацию
+    void followLine(std::string_view line, IpRuns &runs);
+
+    /// Вывод результатов фильтров и агрегации по адресам индекса Follow()
+    void emitRuns(IpRuns &runs);
+
+    /**
+     * @brief Фильтрация ip адресов индекса Follow()
+     * @details Для префикса сливаются только диапазоны серий, остальные функции проверяются для каждого адреса
+     * @tparam Func Тип функции фильтации
+     * @param runs Индекс адресов, все адреса в сериях
+     * @param func Функция фильтрации
+     */
+    template<class Func>
+    void filter_runs(IpRuns const &runs, Func const &func) {
+        bool first{true};
+        uint32_t prev{};
+        auto const out{[this, &first, &prev](uint32_t const ip) {
+            if (!unique || first || ip != prev) {
+                print(ip);
+            }
+            first = false;
+            prev = ip;
+        }};
+
+        if constexpr (std::is_same_v<Func, IpPrefix> || requires { Func::Prefix(); }) {
+            IpPrefix const prefix{to_prefix(func)};
+            runs.ForEachDescending(prefix.First(), prefix.Last(), out);
+        } else {
+            runs.ForEachDescending([&func, &out](uint32_t const ip) {
+                if (func(ip)) {
+                    out(ip);
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Парсинг входного файла с ограничением памяти
+     * @details Используется при SetMaxMemory(). Парсинг общий для обоих стандартов, адреса хранятся упакованными
+     * в сериях ExternalSort. Слияние серий выводит task_1 сразу, совпадения остальных фильтров
+     * откладываются во временные файлы и выводятся после task_1
+     * @return
+     * true - Файл был удачно обработан
+     * false - Ошибка записи временных файлов
+     */
+    [[nodiscard]] bool parsingExternal();
+
+    /**
+     * @brief Парсинг входного файла в битовую карту
+     * @details Используется при Storage::kBitmap. Парсинг общий для обоих стандартов. Без SetUnique()
+     * битовая карта хранит кратность адресов, и вывод совпадает с выводом контейнера
+     * @return true - Файл был удачно обработан
+     */
+    [[nodiscard]] bool parsingBitmap();
+
+    /**
+     * @brief Вывод результатов фильтров, правил и агрегации по адресам битовой карты
+     * @param bitmap Битовая карта адресов
+     */
+    void filterBitmap(IpBitmap const &bitmap);
+
+    /**
+     * @brief Парсинг входного файла с выводом limit наибольших адресов каждого фильтра
+     * @details Используется при SetLimit(). Парсинг общий для обоих стандартов
+     * @return true - Файл был удачно обработан
+     */
+    [[nodiscard]] bool parsingLimit();
+
+    /**
+     * @brief Перенести разобранные адреса контейнера в битовую карту для Storage::kAuto
+     * @details Выполняется до сортировки с SetUnique(), если битовая карта плотных адресов займет не больше
+     * памяти, чем контейнер и буфер поразрядной сортировки. Без SetUnique() кратность повторов хранилась бы
+     * в хеш-таблице, что медленнее сортировки. Контейнер освобождается, результаты выводятся filterBitmap()
+     * @return true - Адреса выведены через битовую карту, сортировка контейнера не нужна
+     */
+    [[nodiscard]] bool denseToBitmap();
+
+    /**
+     * @brief Фильтрация ip адресов битовой карты
+     * @details Для префикса обходятся только слова битовой карты его диапазона, для IpMatch::AnyOctet - блоки
+     * и слова с этим октетом, остальные функции проверяются для каждого адреса карты
+     * @tparam Func Тип функции фильтации
+     * @param bitmap Битовая карта адресов
+     * @param func Функция фильтрации
+     */
+    template<class Func>
+    void filter_bitmap(IpBitmap const &bitmap, Func const &func) {
+        auto const out{[this](uint32_t const ip, uint32_t count) {
+            for (; count != 0; --count) {
+                print(ip);
+            }
+        }};
+
+        if constexpr (std::is_same_v<Func, IpPrefix> || requires { Func::Prefix(); }) {
+            IpPrefix const prefix{to_prefix(func)};
+            bitmap.ForEachDescending(prefix.First(), prefix.Last(), out);
+        } else if constexpr (requires { Func::kOctet; }) {
+            bitmap.ForEachAnyOctetDescending(Func::kOctet, out);
+        } else {
+            bitmap.ForEachDescending([&func, &out](uint32_t const ip, uint32_t const count) {
+                if (func(ip)) {
+                    out(ip, count);
+                }
+            });
+        }
+    }
+
     /**
      * @brief Фильтрация ip адресов
      * @tparam Funcs Тип функции фильтации
      * @param funcs Функции фильтрации
      */
     template<class... Funcs>
-    void filter(Funcs... funcs) {
+    void filter(Funcs const &... funcs) {
         static constexpr int kEmpty{0};
 
         static_assert(sizeof...(Funcs) != kEmpty, "Error ...");
 
-        using func_t = std::function<bool(boost::asio::ip::address_v4 const &)>;
-        std::vector<func_t> vec_funcs{};
-        (vec_funcs.push_back(funcs), ...);
-        for (auto const &func: vec_funcs) {
-            for (auto const &ip: ips_cxx23 | std::views::filter(func)) {
-                print(ip.to_string());
+        (filter_one(funcs), ...);
+    }
+
+    /**
+     * @brief Фильтрация ip адресов одной функцией
+     * @details Для префикса (IpPrefix, IpMatch::MaskMatch с непрерывной маской) в отсортированном по убыванию
+     * контейнере диапазон находится двоичным поиском (для снимка - после сужения таблицей первого октета). Набор CIDR префиксов (CidrSet) проверяется пачками.
+     * Функции от uint32_t вычисляются блоками, остальные - для каждого адреса boost::asio::ip::address_v4
+     * @tparam Func Тип функции фильтации
+     * @param func Функция фильтрации
+     */
+    template<class Func>
+    void filter_one(Func const &func) {
+        if constexpr (std::is_same_v<Func, IpPrefix> || requires { Func::Prefix(); }) {
+            if (sorted_descending) {
+                IpPrefix const prefix{to_prefix(func)};
+                for (uint32_t const ip: indexed ? index.EqualRange(prefix)
+                                               : prefix.EqualRange(addresses(), std::identity{})) {
+                    print(ip);
+                }
+                return;
+            }
+        }
+        if constexpr (std::is_same_v<Func, CidrSet>) {
+            filter_blocks([&func](auto const keys, auto const matched) {
+                func.LookupBatch(keys, matched);
+            });
+        } else if constexpr (std::is_invocable_r_v<bool, Func const &, uint32_t>) {
+            filter_blocks([&func](auto const keys, auto const matched) {
+                for (size_t i{}; i < keys.size(); ++i) {
+                    matched[i] = func(keys[i]);
+                }
+            });
+        } else {
+            for (uint32_t const ip: addresses()) {
+                if (func(to_address(ip))) {
+                    print(ip);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Правила LoadRulesFile(), которым соответствует адрес
+     * @tparam Func Тип функции обработки правила
+     * @param ip Адрес в порядке байт хоста
+     * @param mask Маска правил, размер RuleSet::Words()
+     * @param func Функция обработки: (size_t rule) для каждого совпавшего правила
+     */
+    template<class Func>
+    void forEachRule(uint32_t const ip, std::span<uint64_t> const mask, Func &&func) const {
+        static constexpr size_t kWordBits{64};
+
+        rules->Match(ip, mask);
+        for (size_t w{}; w < mask.size(); ++w) {
+            for (uint64_t bits{mask[w]}; bits != 0; bits &= bits - 1) {
+                func(w * kWordBits + static_cast<size_t>(std::countr_zero(bits)));
             }
         }
     }
+
     /**
-     * @brief Проверка строки на содержимое только чисел
-     * @param str Строка
-     * @return
-     * true - Строка содержит только числа
-     * false - Строка содержить символ(ы)
+     * @brief Вывод ip адресов в потоки правил LoadRulesFile()
+     * @details Один проход по адресам: маска всех правил адреса вычисляется таблицами (RuleSet::Match),
+     * адрес выводится в поток каждого правила маски. Без правил out ничего не выводит
+     * @tparam ForEach Тип обхода адресов
+     * @param for_each Обход адресов по убыванию: for_each(out), out(uint32_t ip, uint32_t count)
      */
-    static bool isAllDigits(std::string const &str);
+    template<class ForEach>
+    void filter_rules(ForEach &&for_each) {
+        std::vector<uint64_t> before(rule_dst.size());
+        for (size_t i{}; i < rule_dst.size(); ++i) {
+            before[i] = rule_dst[i]->NumIps();
+        }
+        std::vector<uint64_t> mask(rules ? rules->Words() : 0);
+        for_each([this, &mask](uint32_t const ip, uint32_t const count) {
+            if (mask.empty()) {
+                return;
+            }
+            forEachRule(ip, mask, [this, ip, count](size_t const rule) {
+                for (uint32_t i{}; i < count; ++i) {
+                    rule_dst[rule]->Write(ip);
+                }
+            });
+        });
+        stats.matches.rules.resize(rule_dst.size());
+        for (size_t i{}; i < rule_dst.size(); ++i) {
+            rule_dst[i]->Flush();
+            stats.matches.rules[i] = rule_dst[i]->NumIps() - before[i];
+        }
+    }
+
+    /// Префикс функции фильтрации
+    static constexpr IpPrefix to_prefix(IpPrefix const &prefix) {
+        return prefix;
+    }
+
+    /// Префикс функции фильтрации
+    template<class Func>
+    static constexpr IpPrefix to_prefix(Func const &) {
+        return Func::Prefix();
+    }
 
     /**
-     * @brief Разбить строку на строки согласно разделителя
-     * @param str Строка
-     * @param delimiter Разделитель
-     * @return Контейнер строк
+     * @brief Фильтрация ip адресов блоками
+     * @details Контейнер проверяется блоками по kFilterBlockSize адресов без копирования, match заполняет
+     * признаки совпадения для всего блока (цикл без вызовов через указатель), затем совпавшие адреса выводятся
+     * @tparam Match Тип функции проверки блока
+     * @param match Функция проверки блока: (std::span<uint32_t const> keys, std::span<uint8_t> matched)
      */
-    static std::vector<std::string> splitString(std::string const &str, char const delimiter);
+    template<class Match>
+    void filter_blocks(Match match) {
+        static constexpr size_t kFilterBlockSize{256};
+
+        std::array<uint8_t, kFilterBlockSize> matched{};
+        auto const sorted{addresses()};
+        for (size_t beg{}; beg < sorted.size(); beg += kFilterBlockSize) {
+            auto const keys{sorted.subspan(beg, std::min(kFilterBlockSize, sorted.size() - beg))};
+            size_t const size{keys.size()};
+            match(keys, std::span<uint8_t>{matched.data(), size});
+            for (size_t i{}; i < size; ++i) {
+                if (matched[i] != 0) {
+                    print(keys[i]);
+                }
+            }
+        }
+    }
 
     /**
      * @brief Парсинг строки ip адреса
      * @details Используется 23 стандарт
      * @param line Строка ip адреса
+     * @param ips Контейнер для ip адреса
+     * @return Результат разбора адреса, для статистики строк
      */
-    void parsing_cxx23(std::string const &line);
+    static IpParser::Status parsing_cxx23(std::string_view line, std::pmr::vector<uint32_t> &ips);
 
     /**
      * @brief Парсинг строки ip адреса
      * @details Используется 17 стандарт
      * @param line Строка ip адреса
+     * @param ips Контейнер для ip адреса
+     * @return Результат разбора адреса, для статистики строк
      */
-    void parsing_cxx17(std::string const &line);
+    static IpParser::Status parsing_cxx17(std::string_view line, std::pmr::vector<uint32_t> &ips);
 
     /**
-     * @brief Парсинг ip элементов
-     * @details Элементы ip получены при парсинге ip строки из входного файла.
-     * ip адрес=1.2.3.4
-     * 1 - 1-й элемент
-     * 2 - 2-й элемент
-     * 3 - 3-й элемент
-     * 4 - 4-й элемент
-     * @param ip_elements Контейнер строк
-     * @return Контенер <ip строк и ip адресов>
+     * @brief Вывод ip адреса
+     * @details Выводит адрес получателю SetSink() или в std::cout или в выходной файл, если он задан в аргументах
+     * программы. Вывод буферизирован (IpWriter), буфер сбрасывается в конце Parsing()
+     * @param ip Адрес в порядке байт хоста
      */
-    static std::tuple<std::string, uint32_t> parsingIpElements(std::vector<std::string> const &ip_elements);
-
-    /**
-     * @brief Вывод строки
-     * @details Всегда выводит строку в std::cout, вывод в выходной файл только если задан в аргументах программы
-     * @param str Строка
-     */
-    void print(std::string const &str);
+    void print(uint32_t const ip) {
+        ++printed;
+        if (sink) {
+            sink(section, ip);
+        } else {
+            dst.Write(ip);
+        }
+    }
 
     void filter_task_1();
 
@@ -258,15 +861,85 @@ private:
 
     void filter_task_4();
 
+    void filter_task_cidr();
+
 private:
+    /// Доступ бенчмарков к закрытым ядрам (bench/ip_filter_kernels.h)
+    friend struct IpFilterKernels;
+
     /// Путь входного файла
     std::string const file{};
-    /// Контейнер для хранения ip адресов после парсинга входного файла
-    std::vector<boost::asio::ip::address_v4> ips_cxx23{};
-    /// Контейнер для хранения ip адресов после парсинга входного файла
-    std::vector<std::tuple<std::string, uint32_t> > ips_cxx17{};
-    /// Выходной файл
-    std::ofstream dst{};
+    /// Ресурс памяти контейнеров со счетчиками выделений
+    CountingResource counting{};
+    /// Контейнер ip адресов после парсинга входного файла, общий для обоих стандартов.
+    /// Адреса упакованы в uint32_t (порядок байт хоста)
+    std::pmr::vector<uint32_t> ips{&counting};
+    /// Контейнер ips отсортирован по убыванию
+    bool sorted_descending{};
+    /// Путь записи снимка
+    std::string save_index{};
+    /// Путь загрузки снимка
+    std::string load_index{};
+    /// Загруженный снимок
+    IpIndex index{};
+    /// Адреса берутся из снимка, а не из контейнера
+    bool indexed{};
+    /// Вывод ip адресов
+    IpWriter dst{};
+    /// Получатель выведенных адресов, задается SetSink()
+    Sink sink{};
+    /// Текущая секция вывода
+    Section section{};
+    /// Количество выведенных адресов (print())
+    uint64_t printed{};
+    /// Начало строки, разрезанной границей частей Feed()
+    std::string feed_tail{};
+    /// Идет ввод Feed(): замер с первого Feed() и количество выделений памяти до него
+    std::optional<PhaseClock> feed_clock{};
+    uint64_t feed_allocations{};
+    /// Набор CIDR префиксов, задается LoadCidrFile()
+    std::optional<CidrSet> cidr{};
+    /// Правила по октетам, задаются LoadRulesFile()
+    std::optional<RuleSet> rules{};
+    /// Потоки вывода правил в порядке правил
+    std::vector<std::unique_ptr<IpWriter> > rule_dst{};
+    /// Количество потоков парсинга
+    unsigned threads{1};
+    /// Ограничение памяти для адресов в байтах, 0 - без ограничения
+    size_t max_memory{};
+    /// Хранилище адресов
+    Storage storage{Storage::kAuto};
+    /// Вывод без повторов
+    bool unique{};
+    /// Количество выводимых адресов каждого фильтра, 0 - без ограничения
+    size_t limit{};
+    /// Суммы счетчиков, задается SetAggregation()
+    std::optional<IpAggregator> aggregator{};
+    /// Количество выводимых префиксов агрегации
+    size_t aggregation_top{};
+    /// Статистика последнего Parsing()
+    IpStats stats{};
+    /// Считать строки по причинам отказа
+    bool collect_stats{};
+    /// Запрошен вывод результатов в Follow()
+    std::atomic<bool> emit_requested{};
+    static_assert(std::atomic<bool>::is_always_lock_free, "RequestEmit() is called from signal handlers");
+    /// Запись self-pipe, которая будит ожидание ввода Follow(int), -1 - Follow(int) не выполняется
+    std::atomic<int> wake_fd{-1};
+    static_assert(std::atomic<int>::is_always_lock_free, "RequestEmit() is called from signal handlers");
+    /// Наименьшее среднее число адресов на занятый блок IpBitmap для битовой карты при Storage::kAuto:
+    /// блок не больше адресов в контейнере и буфере поразрядной сортировки
+    static constexpr size_t kBitmapMinDensity{IpBitmap::kBlockBytes / (2 * sizeof(uint32_t))};
+    /// Размер блока чтения конвейера readStream()
+    static constexpr size_t kPipelineBlockSize{1 << 20};
+    /// Количество блоков конвейера на рабочий поток
+    static constexpr size_t kPipelineBlocks{4};
+    /// Размер блока чтения Follow(int)
+    static constexpr size_t kFollowReadSize{1 << 16};
+    /// Размер буфера потока правила LoadRulesFile()
+    static constexpr size_t kRuleBufferSize{1 << 14};
+    /// Ошибка чтения входных данных в последнем Parsing(): файл не открыт, сжатый файл поврежден или формат не поддержан
+    bool read_error{};
     /// Вариант обработки
     static constexpr int kCxx17{17};
     static constexpr int kCxx23{23};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include "ip_prefix.h"
+#include "mapped_file.h"
+
+/**
+ * @brief Двоичный снимок отсортированных ip адресов
+ * @details Файл: заголовок (Header) и адреса uint32_t, отсортированные по убыванию, в порядке байт машины.
+ * Заголовок хранит версию формата, размер и время изменения исходного файла, таблицу смещений по первому
+ * октету и контрольную сумму адресов и таблицы. Загрузка отображает файл в память, адреса используются
+ * без копирования, парсинг и сортировка не нужны
+ */
+class IpIndex {
+public:
+    /// Исходный файл снимка: размер и время изменения
+    struct Source {
+        uint64_t size{};
+        int64_t mtime{};
+
+        /**
+         * @brief Размер и время изменения файла
+         * @param file Путь до файла
+         * @return Пусто, если файл не существует
+         */
+        [[nodiscard]] static std::optional<Source> Of(std::string const &file);
+
+        bool operator==(Source const &) const = default;
+    };
+
+    IpIndex() = default;
+
+    /**
+     * @brief Запись снимка
+     * @details Файл записывается во временный файл рядом и переименовывается, поэтому читатели не видят
+     * частично записанный снимок
+     * @param file Путь до файла снимка
+     * @param sorted Адреса, отсортированные по убыванию
+     * @param source Исходный файл адресов
+     * @return
+     * true - Снимок записан
+     * false - Ошибка записи
+     */
+    [[nodiscard]] static bool Save(std::string const &file, std::span<uint32_t const> sorted, Source const &source);
+
+    /**
+     * @brief Загрузка снимка
+     * @details Проверяются сигнатура, версия, размер файла, таблица смещений и контрольная сумма
+     * @param file Путь до файла снимка
+     * @return
+     * true - Снимок загружен
+     * false - Файл не существует или поврежден
+     */
+    [[nodiscard]] bool Load(std::string const &file);
+
+    /// Освободить отображение снимка
+    void Close();
+
+    /// Снимок загружен
+    [[nodiscard]] bool IsOpen() const;
+
+    /// Исходный файл загруженного снимка
+    [[nodiscard]] Source GetSource() const;
+
+    /// Адреса загруженного снимка по убыванию, без копирования
+    [[nodiscard]] std::span<uint32_t const> Addresses() const;
+
+    /// Адреса загруженного снимка с первым октетом octet
+    [[nodiscard]] std::span<uint32_t const> FirstOctet(uint8_t octet) const;
+
+    /**
+     * @brief Адреса загруженного снимка, принадлежащие префиксу
+     * @details Диапазон сужается таблицей смещений до первого октета, затем находится двоичным поиском
+     * @param prefix Префикс
+     */
+    [[nodiscard]] std::span<uint32_t const> EqualRange(IpPrefix const &prefix) const;
+
+private:
+    /// Количество значений первого октета
+    static constexpr size_t kNumOctets{256};
+    /// Сдвиг первого октета адреса
+    static constexpr int kFirstOctetShift{24};
+
+    /// Заголовок файла снимка
+    struct Header {
+        std::array<char, 4> magic{};
+        uint32_t version{};
+        uint64_t count{};
+        uint64_t source_size{};
+        int64_t source_mtime{};
+        uint64_t checksum{};
+        /// Адреса с первым октетом o занимают [offsets[kNumOctets - 1 - o], offsets[kNumOctets - o])
+        std::array<uint64_t, kNumOctets + 1> offsets{};
+    };
+
+    static constexpr std::array<char, 4> kMagic{'I', 'P', 'I', 'X'};
+    static constexpr uint32_t kVersion{1};
+
+    /// Контрольная сумма FNV-1a по словам таблицы смещений и адресам
+    [[nodiscard]] static uint64_t checksum(std::span<uint64_t const> offsets, std::span<uint32_t const> sorted);
+
+    /// Отображенный файл снимка
+    std::optional<MappedFile> mapped{};
+    /// Заголовок загруженного снимка
+    Header header{};
+    /// Адреса загруженного снимка
+    std::span<uint32_t const> addresses{};
+};
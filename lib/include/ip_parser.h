@@ -0,0 +1,139 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @brief Разбор строки ip адреса вида "255.255.255.255" без выделения памяти
+ * @details Поле копируется в 16-байтовый блок (два 64-битных слова) и классифицируется по SWAR:
+ * маски точек и цифр строятся сразу для 8 байт, без посимвольных ветвлений.
+ * Правила совпадают с inet_pton (Linux): ровно 4 октета, в октете 1-3 цифры, без ведущих нулей, значение <= 255
+ */
+class IpParser {
+public:
+    /// Результат разбора ip адреса
+    enum class Status : uint8_t {
+        /// Адрес валиден
+        kOk,
+        /// Строка длиннее 15 байт (строка "255.255.255.255")
+        kTooLong,
+        /// Количество точек не равно 3
+        kBadDots,
+        /// Символ не является цифрой или точкой
+        kBadChar,
+        /// Пустой октет, больше 3 цифр, ведущий ноль или значение больше 255
+        kBadOctet,
+    };
+
+    /// Максимальная длина строки ip адреса
+    static constexpr size_t kMaxLenIpStr{15};
+
+    /**
+     * @brief Первое поле строки, разделенной табуляцией
+     * @details Табуляция ищется только в первых kMaxLenIpStr + 1 байтах:
+     * более длинное поле обрезается, но все равно отвергается Parse() как kTooLong
+     * @param line Строка входного файла
+     * @return Строка ip адреса
+     */
+    [[nodiscard]] static constexpr std::string_view FirstField(std::string_view const line) noexcept {
+        std::string_view const head{line.substr(0, kMaxLenIpStr + 1)};
+        return head.substr(0, head.find('\t'));
+    }
+
+    /**
+     * @brief Разбор строки ip адреса
+     * @param field Строка ip адреса
+     * @param ip Адрес в порядке байт хоста (1.2.3.4 = 0x01020304), задается только при Status::kOk
+     * @return Результат разбора
+     */
+    [[nodiscard]] static Status Parse(std::string_view const field, uint32_t &ip) noexcept {
+        static constexpr int kNumPoints{3};
+        static constexpr uint32_t kMaxOctet{255};
+        static constexpr uint32_t kMaxOctetDigits{3};
+        static constexpr int kStep{8};
+
+        size_t const len{field.size()};
+        if (kMaxLenIpStr < len) {
+            return Status::kTooLong;
+        }
+
+        unsigned char block[kBlockSize]{};
+        std::memcpy(block, field.data(), len);
+        uint32_t const len_mask{(1u << len) - 1};
+        uint32_t const dots{(movemask(matchByte(load(block), '.')) |
+                             movemask(matchByte(load(block + kWordSize), '.')) << kWordSize) & len_mask};
+        uint32_t const digits{(movemask(matchDigit(load(block))) |
+                               movemask(matchDigit(load(block + kWordSize))) << kWordSize) & len_mask};
+
+        if (std::popcount(dots) != kNumPoints) {
+            return Status::kBadDots;
+        }
+        if ((dots | digits) != len_mask) {
+            return Status::kBadChar;
+        }
+
+        // Границы октетов: позиции точек и конец строки
+        uint32_t ends{dots | (1u << len)};
+        uint32_t begin{};
+        uint32_t addr{};
+        for (int i{}; i <= kNumPoints; ++i) {
+            auto const end{static_cast<uint32_t>(std::countr_zero(ends))};
+            ends &= ends - 1;
+            uint32_t const num_digits{end - begin};
+            if (num_digits == 0 || kMaxOctetDigits < num_digits || (1 < num_digits && block[begin] == '0')) {
+                return Status::kBadOctet;
+            }
+            uint32_t octet{};
+            for (uint32_t j{begin}; j < end; ++j) {
+                octet = octet * 10 + (block[j] - '0');
+            }
+            if (kMaxOctet < octet) {
+                return Status::kBadOctet;
+            }
+            addr = addr << kStep | octet;
+            begin = end + 1;
+        }
+        ip = addr;
+        return Status::kOk;
+    }
+
+private:
+    static constexpr size_t kBlockSize{16};
+    static constexpr size_t kWordSize{8};
+    static constexpr uint64_t kOnes{0x0101010101010101ull};
+    static constexpr uint64_t kHigh{0x8080808080808080ull};
+    static constexpr uint64_t kLow{0x7F7F7F7F7F7F7F7Full};
+    static constexpr uint64_t kGather{0x0102040810204080ull};
+    static constexpr int kGatherShift{56};
+
+    /// Загрузка 8 байт, байт i попадает в биты [8 * i, 8 * i + 7]
+    static uint64_t load(unsigned char const *ptr) noexcept {
+        uint64_t word{};
+        std::memcpy(&word, ptr, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = std::byteswap(word);
+        }
+        return word;
+    }
+
+    /// Старший бит установлен в байтах, равных ch
+    static constexpr uint64_t matchByte(uint64_t const word, unsigned char const ch) noexcept {
+        uint64_t const x{word ^ (kOnes * ch)};
+        return ~(((x & kLow) + kLow) | x | kLow);
+    }
+
+    /// Старший бит установлен в байтах '0'..'9'
+    static constexpr uint64_t matchDigit(uint64_t const word) noexcept {
+        uint64_t const low{word & kLow};
+        uint64_t const ge_0{(low + kOnes * (0x80 - '0')) & kHigh};
+        uint64_t const ge_10{(low + kOnes * (0x80 - '9' - 1)) & kHigh};
+        return ge_0 & ~ge_10 & ~word;
+    }
+
+    /// Сжатие старших битов 8 байт в 8-битную маску (аналог _mm_movemask_epi8)
+    static constexpr uint32_t movemask(uint64_t const word) noexcept {
+        return static_cast<uint32_t>((((word & kHigh) >> 7) * kGather) >> kGatherShift);
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <boost/asio/ip/address_v4.hpp>
+#include "ip_prefix.h"
+
+/**
+ * @brief Предикаты фильтрации ip адресов, собираемые на этапе компиляции
+ * @details Предикат - тип без состояния с constexpr operator()(uint32_t). Вызов встраивается в цикл фильтрации
+ * без std::function, и цикл по массиву uint32_t может быть векторизован компилятором
+ */
+namespace IpMatch {
+    /// Любое значение октета
+    static constexpr int kAny{-1};
+
+    namespace detail {
+        static constexpr int kNumOctets{4};
+        static constexpr int kOctetBits{8};
+        static constexpr uint32_t kOctetMask{0xFF};
+
+        /// Маска адреса: 0xFF для заданных октетов, 0 для kAny
+        template<int... Octets>
+        constexpr uint32_t mask() {
+            static_assert(sizeof...(Octets) == kNumOctets, "ip address has 4 octets");
+            static_assert(((Octets == kAny || (0 <= Octets && Octets <= 0xFF)) && ...), "octet is 0..255 or kAny");
+
+            uint32_t mask{};
+            ((mask = mask << kOctetBits | (Octets == kAny ? 0 : kOctetMask)), ...);
+            return mask;
+        }
+
+        /// Значение адреса под маской
+        template<int... Octets>
+        constexpr uint32_t value() {
+            uint32_t value{};
+            ((value = value << kOctetBits | (Octets == kAny ? 0 : static_cast<uint32_t>(Octets))), ...);
+            return value;
+        }
+    }
+
+    /**
+     * @brief Совпадение адреса по маске: (ip & Mask) == Value
+     * @details Если маска непрерывная (старшие биты), предикат является префиксом:
+     * его адреса находятся двоичным поиском через Prefix()
+     */
+    template<uint32_t Mask, uint32_t Value>
+    struct MaskMatch {
+        static_assert((Value & ~Mask) == 0, "value has bits outside of the mask");
+
+        /// Маска состоит из старших бит
+        static constexpr bool kIsPrefix{std::countl_one(Mask) + std::countr_zero(Mask) == 32};
+
+        constexpr bool operator()(uint32_t const ip) const {
+            return (ip & Mask) == Value;
+        }
+
+        bool operator()(boost::asio::ip::address_v4 const &ip) const {
+            return (*this)(ip.to_uint());
+        }
+
+        /// Префикс, соответствующий маске
+        static constexpr IpPrefix Prefix() requires kIsPrefix {
+            return {Value, std::countl_one(Mask)};
+        }
+    };
+
+    /**
+     * @brief Совпадение адреса по октетам
+     * @details Octets<46, 70, kAny, kAny> - адреса 46.70.*.*
+     */
+    template<int... Values>
+    using Octets = MaskMatch<detail::mask<Values...>(), detail::value<Values...>()>;
+
+    /**
+     * @brief Хотя бы один октет адреса равен Octet
+     * @details Все 4 октета проверяются одной операцией: поиск нулевого байта в ip ^ Octet.Octet.Octet.Octet
+     */
+    template<uint8_t Octet>
+    struct AnyOctet {
+        /// Искомое значение октета
+        static constexpr uint8_t kOctet{Octet};
+
+        constexpr bool operator()(uint32_t const ip) const {
+            constexpr uint32_t kOnes{0x01010101};
+            constexpr uint32_t kHigh{0x80808080};
+
+            uint32_t const x{ip ^ (kOnes * Octet)};
+            return ((x - kOnes) & ~x & kHigh) != 0;
+        }
+
+        bool operator()(boost::asio::ip::address_v4 const &ip) const {
+            return (*this)(ip.to_uint());
+        }
+    };
+
+    /// Выполняется хотя бы один предикат. Предикаты вычисляются без ветвлений
+    template<class... Preds>
+    struct AnyOf {
+        constexpr bool operator()(uint32_t const ip) const {
+            return (static_cast<bool>(Preds{}(ip)) | ...);
+        }
+
+        bool operator()(boost::asio::ip::address_v4 const &ip) const {
+            return (*this)(ip.to_uint());
+        }
+    };
+
+    /// Выполняются все предикаты. Предикаты вычисляются без ветвлений
+    template<class... Preds>
+    struct AllOf {
+        constexpr bool operator()(uint32_t const ip) const {
+            return (static_cast<bool>(Preds{}(ip)) & ...);
+        }
+
+        bool operator()(boost::asio::ip::address_v4 const &ip) const {
+            return (*this)(ip.to_uint());
+        }
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <boost/asio/ip/address_v4.hpp>
+
+/**
+ * @brief Префикс ip адреса: старшие length бит равны старшим битам value
+ * @details Используется как предикат фильтрации. В контейнере, отсортированном по убыванию,
+ * адреса с одним префиксом образуют непрерывный диапазон, который находится двоичным поиском
+ */
+struct IpPrefix {
+    /// Адрес префикса в порядке байт хоста
+    uint32_t value{};
+    /// Длина префикса в битах: 0..32
+    int length{};
+
+    /// Маска префикса
+    [[nodiscard]] constexpr uint32_t Mask() const {
+        constexpr int kBits{32};
+
+        return length == 0 ? 0 : ~uint32_t{} << (kBits - length);
+    }
+
+    /// Наименьший адрес префикса
+    [[nodiscard]] constexpr uint32_t First() const {
+        return value & Mask();
+    }
+
+    /// Наибольший адрес префикса
+    [[nodiscard]] constexpr uint32_t Last() const {
+        return value | ~Mask();
+    }
+
+    constexpr bool operator()(uint32_t const ip) const {
+        return (ip & Mask()) == First();
+    }
+
+    bool operator()(boost::asio::ip::address_v4 const &ip) const {
+        return (*this)(ip.to_uint());
+    }
+
+    /**
+     * @brief Диапазон адресов префикса
+     * @details Двоичный поиск, O(log n)
+     * @tparam T Тип элемента
+     * @tparam Key Тип функции получения ключа
+     * @param sorted Контейнер, отсортированный по убыванию ключа
+     * @param key Функция получения ключа uint32_t из элемента
+     * @return Подмножество sorted, ключи которого принадлежат префиксу
+     */
+    template<class T, class Key>
+    [[nodiscard]] std::span<T const> EqualRange(std::span<T const> const sorted, Key key) const {
+        auto const beg{std::ranges::partition_point(sorted, [this, &key](T const &elm) {
+            return Last() < key(elm);
+        })};
+        auto const end{std::ranges::partition_point(beg, sorted.end(), [this, &key](T const &elm) {
+            return First() <= key(elm);
+        })};
+        return {beg, end};
+    }
+};
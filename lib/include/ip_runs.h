@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Инкрементальный отсортированный индекс ip адресов: LSM из отсортированных серий
+ * @details Адреса добавляются в буфер, заполненный буфер сортируется по убыванию (RadixSort) и становится
+ * новой серией. Серии хранятся от старых (больших) к новым (меньшим); пока предыдущая серия не больше
+ * kMergeRatio новых, две последние серии сливаются. Поэтому каждый адрес сливается O(log n) раз, серий
+ * O(log n), а обход по убыванию сливает серии на лету без полной пересортировки
+ */
+class IpRuns {
+public:
+    /// Размер буфера по умолчанию
+    static constexpr size_t kDefaultBufferSize{1 << 16};
+
+    /**
+     * @brief Конструктор
+     * @param buffer_size Количество адресов в буфере до образования серии
+     * @param resource Ресурс памяти буфера и серий
+     */
+    explicit IpRuns(size_t buffer_size = kDefaultBufferSize,
+                    std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief Добавить ip адрес
+     * @param ip Адрес в порядке байт хоста
+     */
+    void Insert(uint32_t const ip) {
+        buffer.push_back(ip);
+        if (buffer.size() == buffer_size) {
+            Seal();
+        }
+    }
+
+    /// Отсортировать буфер в новую серию и слить серии сопоставимого размера
+    void Seal();
+
+    /// Количество добавленных адресов с повторами
+    [[nodiscard]] size_t Size() const;
+
+    /// Количество серий (без буфера)
+    [[nodiscard]] size_t NumRuns() const;
+
+    /**
+     * @brief Обход адресов серий диапазона [first, last] по убыванию
+     * @details Адреса буфера не обходятся, перед обходом нужен Seal(). В каждой серии диапазон находится
+     * двоичным поиском, затем части серий сливаются через кучу
+     * @tparam Func Тип функции обработки адреса
+     * @param first Первый адрес диапазона
+     * @param last Последний адрес диапазона
+     * @param func Функция обработки: (uint32_t ip), повторы передаются столько раз, сколько добавлены
+     */
+    template<class Func>
+    void ForEachDescending(uint32_t const first, uint32_t const last, Func &&func) const {
+        // Куча частей серий по текущему (наибольшему) адресу
+        std::vector<std::span<uint32_t const> > parts{};
+        parts.reserve(runs.size());
+        for (auto const &run: runs) {
+            auto const beg{std::ranges::partition_point(run, [last](uint32_t const ip) { return last < ip; })};
+            auto const end{std::ranges::partition_point(beg, run.end(), [first](uint32_t const ip) { return first <= ip; })};
+            if (beg != end) {
+                parts.emplace_back(beg, end);
+            }
+        }
+        auto const less{[](std::span<uint32_t const> const lhs, std::span<uint32_t const> const rhs) {
+            return lhs.front() < rhs.front();
+        }};
+        std::ranges::make_heap(parts, less);
+        while (!parts.empty()) {
+            std::ranges::pop_heap(parts, less);
+            auto &part{parts.back()};
+            func(part.front());
+            if (part = part.subspan(1); part.empty()) {
+                parts.pop_back();
+            } else {
+                std::ranges::push_heap(parts, less);
+            }
+        }
+    }
+
+    /**
+     * @brief Обход всех адресов серий по убыванию
+     * @tparam Func Тип функции обработки адреса
+     * @param func Функция обработки: (uint32_t ip)
+     */
+    template<class Func>
+    void ForEachDescending(Func &&func) const {
+        ForEachDescending(0, ~uint32_t{}, func);
+    }
+
+private:
+    /// Слить две последние серии
+    void mergeLast();
+
+    /// Серия сливается с предыдущей, пока предыдущая не больше kMergeRatio таких серий
+    static constexpr size_t kMergeRatio{2};
+
+    /// Размер буфера
+    size_t const buffer_size;
+    /// Ресурс памяти буфера и серий
+    std::pmr::memory_resource *const resource;
+    /// Несортированные адреса
+    std::pmr::vector<uint32_t> buffer;
+    /// Серии, отсортированные по убыванию, от старых к новым
+    std::vector<std::pmr::vector<uint32_t> > runs{};
+};
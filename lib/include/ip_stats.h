@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ip_parser.h"
+
+/**
+ * @brief Статистика обработки входного файла
+ * @details Время фаз (монотонные часы), объем входных данных, принятые и отвергнутые строки по причинам
+ * IpParser::Status, количество совпадений каждого фильтра
+ */
+struct IpStats {
+    using duration_t = std::chrono::nanoseconds;
+
+    /// Время фаз
+    struct Phases {
+        /// Загрузка страниц отображенного файла (для потоков ввода чтение входит в parse)
+        duration_t read{};
+        /// Разбор строк и заполнение хранилища адресов
+        duration_t parse{};
+        /// Сортировка (для внешней сортировки - подготовка слияния)
+        duration_t sort{};
+        /// Фильтры и форматирование вывода
+        duration_t filter{};
+        /// Запись вывода
+        duration_t write{};
+        /// Весь Parsing()
+        duration_t total{};
+    };
+
+    /// Количество совпадений фильтров
+    struct Matches {
+        uint64_t task_1{};
+        uint64_t task_2{};
+        uint64_t task_3{};
+        uint64_t task_4{};
+        uint64_t cidr{};
+        /// Совпадения правил RuleSet в порядке правил
+        std::vector<uint64_t> rules{};
+    };
+
+    /// Количество причин отказа (IpParser::Status без kOk)
+    static constexpr size_t kNumReasons{4};
+
+    /// Учесть строку по результату разбора ip адреса
+    void Count(IpParser::Status const status) {
+        ++lines;
+        if (status == IpParser::Status::kOk) {
+            ++accepted;
+        } else {
+            ++rejected[static_cast<size_t>(status) - 1];
+        }
+    }
+
+    /// Добавить счетчики строк другой статистики, например, части файла из другого потока
+    void Merge(IpStats const &other);
+
+    /// Количество отвергнутых строк
+    [[nodiscard]] uint64_t Rejected() const;
+
+    /**
+     * @brief Статистика в JSON
+     * @details {"bytes", "lines", "accepted", "rejected": {...}, "matches": {..., "rules": [...]}, "memory": {...}, "phases_ns": {...}}
+     */
+    [[nodiscard]] std::string ToJson() const;
+
+    Phases phases{};
+    /// Прочитано байт входных данных
+    uint64_t bytes{};
+    /// Прочитано строк
+    uint64_t lines{};
+    /// Строк с валидным ip адресом
+    uint64_t accepted{};
+    /// Отвергнутые строки: kTooLong, kBadDots, kBadChar, kBadOctet
+    std::array<uint64_t, kNumReasons> rejected{};
+    Matches matches{};
+    /// Выделений памяти контейнеров адресов за Parsing()
+    uint64_t allocations{};
+    /// Максимум памяти контейнеров адресов в байтах
+    uint64_t peak_bytes{};
+    /// Максимальный резидентный размер процесса в КБ, 0 - не поддерживается
+    uint64_t max_rss_kb{};
+};
+
+/// Максимальный резидентный размер процесса в КБ (getrusage), 0 - не поддерживается
+[[nodiscard]] uint64_t MaxRssKb();
+
+/**
+ * @brief Замер фаз
+ * @details Каждая отметка добавляет к фазе время с предыдущей отметки
+ */
+class PhaseClock {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    PhaseClock() = default;
+
+    /**
+     * @brief Завершить фазу
+     * @param phase Время фазы
+     */
+    void Mark(IpStats::duration_t &phase) {
+        auto const now{clock_t::now()};
+        phase += now - last;
+        last = now;
+    }
+
+    /// Время с создания
+    [[nodiscard]] IpStats::duration_t Total() const {
+        return clock_t::now() - start;
+    }
+
+private:
+    clock_t::time_point const start{clock_t::now()};
+    clock_t::time_point last{start};
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Буферизированный вывод ip адресов
+ * @details Адреса форматируются в переиспользуемый буфер по таблице октет -> цифры (256 записей),
+ * без std::ostream и без std::string на каждую строку. Полный буфер сбрасывается одним вызовом write()
+ * в выходной файл или одним sputn() в текущий буфер std::cout (это сохраняет перенаправление std::cout).
+ * Буфер выделяется при первой записи
+ */
+class IpWriter {
+public:
+    /// Открытие выходного файла
+    enum class Open : uint8_t {
+        /// Файл открыт все время жизни объекта
+        kKeep,
+        /// Файл открывается на дозапись на время сброса буфера, например, для тысяч потоков правил
+        kOnFlush,
+    };
+
+    /**
+     * @brief Конструктор. Создать выходной файл
+     * @details Если файл не задан, вывод выполняется в std::cout. Если файл не удалось создать,
+     * Good() возвращает false и вывод не выполняется
+     * @param file Путь до выходного файла
+     * @param buffer_size Размер буфера в байтах, не меньше длины строки адреса
+     * @param open Открытие файла
+     */
+    explicit IpWriter(std::string const &file = "", size_t buffer_size = kBufferSize, Open open = Open::kKeep);
+
+    ~IpWriter();
+
+    IpWriter(IpWriter const &) = delete;
+
+    IpWriter &operator=(IpWriter const &) = delete;
+
+    /**
+     * @brief Вывод ip адреса и '\n'
+     * @param ip Адрес в порядке байт хоста
+     */
+    void Write(uint32_t const ip) {
+        static constexpr int kOctetBits{8};
+        static constexpr uint32_t kOctetMask{0xFF};
+
+        if (buffer.size() - pos < kMaxLineSize) {
+            makeRoom();
+        }
+        char *ptr{buffer.data() + pos};
+        // Запись копирует 4 байта, лишний байт длины перетирается следующим символом
+        for (int shift{24}; shift > 0; shift -= kOctetBits) {
+            auto const &digits{kOctetDigits[(ip >> shift) & kOctetMask]};
+            std::memcpy(ptr, digits.data(), digits.size());
+            ptr += digits[kLenIndex];
+            *ptr++ = '.';
+        }
+        auto const &digits{kOctetDigits[ip & kOctetMask]};
+        std::memcpy(ptr, digits.data(), digits.size());
+        ptr += digits[kLenIndex];
+        *ptr++ = '\n';
+        pos = static_cast<size_t>(ptr - buffer.data());
+        ++num_ips;
+    }
+
+    /**
+     * @brief Вывод строки и '\n'
+     * @param line Строка
+     */
+    void Write(std::string_view line);
+
+    /// Сбросить буфер
+    void Flush();
+
+    /// Вывод выполняется в файл
+    [[nodiscard]] bool IsFile() const;
+
+    /// Ошибок записи не было. Ошибка запоминается, данные после нее не выводятся
+    [[nodiscard]] bool Good() const;
+
+    /// Количество выведенных ip адресов (Write(uint32_t))
+    [[nodiscard]] uint64_t NumIps() const;
+
+    /// Суммарное время сброса буфера (write() или sputn())
+    [[nodiscard]] std::chrono::nanoseconds WriteTime() const;
+
+    /// Размер буфера по умолчанию
+    static constexpr size_t kBufferSize{1 << 18};
+    /// Строка "255.255.255.255\n"
+    static constexpr size_t kMaxLineSize{16};
+
+private:
+    /// Индекс длины в записи таблицы
+    static constexpr int kLenIndex{3};
+
+    /// Таблица октет -> {цифры, длина}
+    static constexpr auto kOctetDigits{
+        [] {
+            std::array<std::array<char, 4>, 256> table{};
+            for (int octet{}; octet < 256; ++octet) {
+                auto &entry{table[octet]};
+                int len{};
+                if (100 <= octet) {
+                    entry[len++] = static_cast<char>('0' + octet / 100);
+                }
+                if (10 <= octet) {
+                    entry[len++] = static_cast<char>('0' + octet / 10 % 10);
+                }
+                entry[len++] = static_cast<char>('0' + octet % 10);
+                entry[kLenIndex] = static_cast<char>(len);
+            }
+            return table;
+        }()
+    };
+
+    /// Сбросить буфер и выделить его при первой записи
+    void makeRoom();
+
+    /// Запись данных в файл или в std::cout
+    void writeAll(char const *data, size_t size);
+
+    /// Запись данных в открытый файл
+    void writeFile(char const *data, size_t size);
+
+    /// Путь до выходного файла, пустая строка - вывод в std::cout
+    std::string path{};
+    /// Открытие файла
+    Open open{};
+    /// Размер буфера
+    size_t buffer_size{};
+    /// Буфер вывода
+    std::vector<char> buffer{};
+    /// Заполненная часть буфера
+    size_t pos{};
+    /// Количество выведенных ip адресов
+    uint64_t num_ips{};
+    /// Время сброса буфера
+    std::chrono::nanoseconds write_time{};
+    /// Ошибка записи
+    bool failed{};
+#ifdef WINDOWS_SPECIFIC_FLAG
+    /// Выходной файл
+    std::ofstream dst{};
+#else
+    /// Дескриптор открытого выходного файла, -1 - файл закрыт
+    int fd{-1};
+#endif
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Входной файл, отображенный в память только для чтения
+ * @details Данные файла доступны как std::string_view без копирования в std::string.
+ * Для последовательного чтения ядру передается подсказка madvise(MADV_SEQUENTIAL).
+ * В Windows отображение не поддерживается и IsOpen() всегда возвращает false
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Конструктор. Отобразить файл в память
+     * @param file Путь до файла
+     */
+    explicit MappedFile(std::string const &file);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    /**
+     * @brief Состояние отображения файла
+     * @return
+     * true - Файл отображен в память (пустой файл тоже считается отображенным)
+     * false - Файл не удалось открыть или отобразить
+     */
+    [[nodiscard]] bool IsOpen() const;
+
+    /// Содержимое файла
+    [[nodiscard]] std::string_view View() const;
+
+    /**
+     * @brief Загрузить страницы файла
+     * @details Читает по одному байту на страницу, чтобы ввод с диска выполнился до обхода строк
+     * и его время можно было замерить отдельно
+     */
+    void Prefault() const;
+
+    /**
+     * @brief Обход строк текста без копирования
+     * @details Разбивает текст по '\n' так же, как std::getline: последняя строка без '\n' тоже обрабатывается
+     * @tparam Func Тип функции обработки строки
+     * @param text Текст
+     * @param func Функция обработки строки, принимает std::string_view
+     */
+    template<class Func>
+    static void ForEachLine(std::string_view text, Func &&func) {
+        char const *cur{text.data()};
+        char const *const end{text.data() + text.size()};
+        while (cur < end) {
+            auto const *const eol{static_cast<char const *>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)))};
+            char const *const line_end{eol ? eol : end};
+            func(std::string_view{cur, static_cast<size_t>(line_end - cur)});
+            cur = line_end + 1;
+        }
+    }
+
+    /**
+     * @brief Разбиение текста на части по границам строк
+     * @details Части примерно равны по размеру, каждая кроме последней заканчивается символом '\n'.
+     * Строка целиком попадает в одну часть, поэтому части можно обрабатывать независимо
+     * @param text Текст
+     * @param num_parts Желаемое количество частей
+     * @return Части текста, их не больше num_parts, пустые части не возвращаются
+     */
+    [[nodiscard]] static std::vector<std::string_view> SplitLines(std::string_view text, size_t num_parts);
+
+    /**
+     * @brief Оценка количества строк текста для резервирования контейнеров
+     * @details Небольшой текст считается целиком. У большого текста '\n' считаются в нескольких выборках,
+     * равномерно расположенных по тексту, средняя длина строки выборок переносится на весь размер текста.
+     * К оценке добавляется запас 1/16, чтобы контейнер не перевыделялся при небольшой ошибке оценки
+     * @param text Текст
+     * @return Оценка сверху количества строк, не меньше 1
+     */
+    [[nodiscard]] static size_t EstimateLines(std::string_view text);
+
+private:
+    /// Начало отображенной области
+    char const *data{};
+    /// Размер файла
+    size_t size{};
+    /// Файл отображен в память
+    bool is_open{};
+};
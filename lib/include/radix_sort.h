@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Поразрядная (LSD) сортировка по 32-битному ключу
+ * @details 4 прохода по 8 бит. Гистограммы всех разрядов строятся за один проход,
+ * разряд пропускается, если у всех ключей он одинаковый. Сортировка устойчивая.
+ * Параллельный вариант сначала раскладывает элементы по старшему разряду (MSD) в 256 корзин,
+ * затем корзины сортируются по младшим разрядам независимо в нескольких потоках
+ */
+class RadixSort {
+public:
+    /**
+     * @brief Сортировка по убыванию ключа
+     * @details Временный буфер выделяется аллокатором контейнера
+     * @tparam T Тип элемента
+     * @tparam Alloc Тип аллокатора
+     * @tparam Key Тип функции получения ключа
+     * @param vec Контейнер
+     * @param key Функция получения ключа uint32_t из элемента
+     */
+    template<class T, class Alloc, class Key>
+    static void Descending(std::vector<T, Alloc> &vec, Key key) {
+        if (vec.size() < kMinSize) {
+            std::stable_sort(vec.begin(), vec.end(), [&key](T const &lhs, T const &rhs) {
+                return key(rhs) < key(lhs);
+            });
+            return;
+        }
+
+        // Для убывания сортируется инвертированный ключ
+        auto const digit{
+            [&key](T const &elm, int const pass) {
+                return (~static_cast<uint32_t>(key(elm)) >> (pass * kDigitBits)) & kDigitMask;
+            }
+        };
+
+        std::array<std::array<size_t, kNumBuckets>, kNumPasses> counts{};
+        for (auto const &elm: vec) {
+            for (int pass{}; pass < kNumPasses; ++pass) {
+                ++counts[pass][digit(elm, pass)];
+            }
+        }
+
+        std::vector<T, Alloc> buffer(vec.size(), vec.get_allocator());
+        std::vector<T, Alloc> *src{&vec};
+        std::vector<T, Alloc> *dst{&buffer};
+        for (int pass{}; pass < kNumPasses; ++pass) {
+            auto &count{counts[pass]};
+            if (std::ranges::find(count, vec.size()) != count.end()) {
+                continue;
+            }
+            std::array<size_t, kNumBuckets> offsets{};
+            for (size_t i{}, sum{}; i < kNumBuckets; ++i) {
+                offsets[i] = sum;
+                sum += count[i];
+            }
+            for (auto &elm: *src) {
+                (*dst)[offsets[digit(elm, pass)]++] = std::move(elm);
+            }
+            std::swap(src, dst);
+        }
+        if (src != &vec) {
+            vec = std::move(*src);
+        }
+    }
+
+    /**
+     * @brief Параллельная сортировка по убыванию ключа
+     * @details Потоки строят гистограммы старшего разряда своих частей контейнера и раскладывают элементы
+     * в корзины по старшему разряду без блокировок: смещение части в корзине известно из гистограмм.
+     * Затем потоки забирают корзины от больших к меньшим и сортируют их младшими разрядами. Если почти все
+     * ключи в одной корзине (один старший разряд), вторая фаза выполняется одним потоком
+     * @tparam T Тип элемента
+     * @tparam Alloc Тип аллокатора
+     * @tparam Key Тип функции получения ключа
+     * @param vec Контейнер
+     * @param key Функция получения ключа uint32_t из элемента
+     * @param num_threads Количество потоков, 0 и 1 - сортировка в вызывающем потоке; больше kNumBuckets
+     * не используется: корзина старшего разряда сортируется одним потоком
+     */
+    template<class T, class Alloc, class Key>
+    static void Descending(std::vector<T, Alloc> &vec, Key key, unsigned num_threads) {
+        num_threads = std::min(num_threads, static_cast<unsigned>(kNumBuckets));
+        if (num_threads <= 1 || vec.size() < kMinParallelSize) {
+            Descending(vec, key);
+            return;
+        }
+
+        auto const digit{
+            [&key](T const &elm, int const pass) {
+                return (~static_cast<uint32_t>(key(elm)) >> (pass * kDigitBits)) & kDigitMask;
+            }
+        };
+        static constexpr int kHighPass{kNumPasses - 1};
+
+        // Гистограммы старшего разряда по частям контейнера
+        size_t const size{vec.size()};
+        size_t const num_parts{num_threads};
+        auto const part_beg{[size, num_parts](size_t const part) { return size * part / num_parts; }};
+        std::vector<std::array<size_t, kNumBuckets> > offsets(num_parts);
+        parallel(num_parts, [&](size_t const part) {
+            auto &count{offsets[part]};
+            for (size_t i{part_beg(part)}; i < part_beg(part + 1); ++i) {
+                ++count[digit(vec[i], kHighPass)];
+            }
+        });
+
+        // Корзины по порядку, внутри корзины - части по порядку, поэтому раскладка устойчивая
+        std::array<size_t, kNumBuckets + 1> buckets{};
+        for (size_t bucket{}, sum{}; bucket < kNumBuckets; ++bucket) {
+            buckets[bucket] = sum;
+            for (auto &count: offsets) {
+                sum += std::exchange(count[bucket], sum);
+            }
+        }
+        buckets[kNumBuckets] = size;
+
+        std::vector<T, Alloc> buffer(size, vec.get_allocator());
+        parallel(num_parts, [&](size_t const part) {
+            auto &offset{offsets[part]};
+            for (size_t i{part_beg(part)}; i < part_beg(part + 1); ++i) {
+                buffer[offset[digit(vec[i], kHighPass)]++] = std::move(vec[i]);
+            }
+        });
+
+        // Корзины от больших к меньшим, чтобы потоки заканчивали примерно одновременно
+        std::array<size_t, kNumBuckets> order{};
+        std::iota(order.begin(), order.end(), size_t{});
+        std::ranges::sort(order, std::greater{}, [&buckets](size_t const bucket) {
+            return buckets[bucket + 1] - buckets[bucket];
+        });
+        std::atomic<size_t> next{};
+        parallel(num_threads, [&](size_t) {
+            for (size_t n{}; (n = next.fetch_add(1, std::memory_order_relaxed)) < kNumBuckets;) {
+                size_t const beg{buckets[order[n]]};
+                size_t const end{buckets[order[n] + 1]};
+                sortLow(buffer.data() + beg, vec.data() + beg, end - beg, key, digit);
+            }
+        });
+    }
+
+private:
+    /**
+     * @brief Сортировка корзины по младшим разрядам
+     * @details Элементы переносятся между src и dst на каждом проходе, результат всегда в dst
+     * @param src Элементы корзины
+     * @param dst Место результата того же размера
+     * @param size Размер корзины
+     */
+    template<class T, class Key, class Digit>
+    static void sortLow(T *src, T *dst, size_t const size, Key const &key, Digit const &digit) {
+        static constexpr int kNumLowPasses{kNumPasses - 1};
+
+        if (size < kMinSize) {
+            std::move(src, src + size, dst);
+            std::stable_sort(dst, dst + size, [&key](T const &lhs, T const &rhs) {
+                return key(rhs) < key(lhs);
+            });
+            return;
+        }
+
+        std::array<std::array<size_t, kNumBuckets>, kNumLowPasses> counts{};
+        for (size_t i{}; i < size; ++i) {
+            for (int pass{}; pass < kNumLowPasses; ++pass) {
+                ++counts[pass][digit(src[i], pass)];
+            }
+        }
+        T *const result{dst};
+        for (int pass{}; pass < kNumLowPasses; ++pass) {
+            auto &count{counts[pass]};
+            if (std::ranges::find(count, size) != count.end()) {
+                continue;
+            }
+            std::array<size_t, kNumBuckets> offsets{};
+            for (size_t i{}, sum{}; i < kNumBuckets; ++i) {
+                offsets[i] = sum;
+                sum += count[i];
+            }
+            for (size_t i{}; i < size; ++i) {
+                dst[offsets[digit(src[i], pass)]++] = std::move(src[i]);
+            }
+            std::swap(src, dst);
+        }
+        if (src != result) {
+            std::move(src, src + size, result);
+        }
+    }
+
+    /// Вызов func(0), ..., func(n - 1) в n потоках, func(0) - в вызывающем
+    template<class Func>
+    static void parallel(size_t const n, Func const &func) {
+        std::vector<std::jthread> workers{};
+        workers.reserve(n - 1);
+        for (size_t i{1}; i < n; ++i) {
+            workers.emplace_back(func, i);
+        }
+        func(0);
+    }
+
+    /// Меньшие контейнеры сортируются сравнением
+    static constexpr size_t kMinSize{256};
+    /// Меньшие контейнеры сортируются в вызывающем потоке
+    static constexpr size_t kMinParallelSize{1 << 16};
+    static constexpr int kDigitBits{8};
+    static constexpr uint32_t kDigitMask{0xFF};
+    static constexpr size_t kNumBuckets{256};
+    static constexpr int kNumPasses{4};
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Набор правил по октетам, компилируемый во время выполнения
+ * @details Каждое правило - бит в маске из Words() слов uint64_t. Для каждого октета адреса есть таблица
+ * из 256 масок: бит правила установлен, если значение октета удовлетворяет правилу. Маска адреса -
+ * пересечение масок четырех октетов (шаблоны "a.b.c.d") и объединение масок "any==n". Проверка всех правил -
+ * 8 чтений таблиц на слово маски без ветвлений, независимо от количества правил в слове
+ */
+class RuleSet {
+public:
+    /// Правило
+    struct Rule {
+        /// Шаблон, как он записан в файле
+        std::string pattern{};
+        /// Путь вывода совпавших адресов
+        std::string output{};
+    };
+
+    RuleSet() = default;
+
+    /**
+     * @brief Загрузка правил из файла
+     * @details Строка файла: "шаблон [путь вывода]". Без пути вывод идет в "<file>.<номер правила>", номера с 1.
+     * Пустые строки и строки с '#' пропускаются, невалидные строки пропускаются и учитываются в Rejected()
+     * @param file Путь до файла
+     * @return
+     * true - Файл прочитан
+     * false - Ошибка чтения файла
+     */
+    [[nodiscard]] bool Load(std::string const &file);
+
+    /**
+     * @brief Добавить правило
+     * @details Шаблоны: "a.b.c.d", где октет - число, диапазон "n-m" или "*"; "a.b.c.d/len" - CIDR префикс;
+     * "any==n" - хотя бы один октет равен n
+     * @param pattern Шаблон
+     * @param output Путь вывода совпавших адресов
+     * @return false - Шаблон невалиден, правило не добавлено
+     */
+    [[nodiscard]] bool Add(std::string_view pattern, std::string output = "");
+
+    /**
+     * @brief Маска правил, которым соответствует адрес
+     * @param ip Адрес в порядке байт хоста
+     * @param mask Маска, размер не меньше Words(). Бит i слова w - правило w * 64 + i
+     */
+    void Match(uint32_t const ip, std::span<uint64_t> const mask) const {
+        uint64_t const *const octet_0{row(0, ip >> 24)};
+        uint64_t const *const octet_1{row(1, ip >> 16 & kOctetMask)};
+        uint64_t const *const octet_2{row(2, ip >> 8 & kOctetMask)};
+        uint64_t const *const octet_3{row(3, ip & kOctetMask)};
+        uint64_t const *const any_0{anyRow(ip >> 24)};
+        uint64_t const *const any_1{anyRow(ip >> 16 & kOctetMask)};
+        uint64_t const *const any_2{anyRow(ip >> 8 & kOctetMask)};
+        uint64_t const *const any_3{anyRow(ip & kOctetMask)};
+        for (size_t w{}; w < words; ++w) {
+            mask[w] = (octet_0[w] & octet_1[w] & octet_2[w] & octet_3[w]) | (any_0[w] | any_1[w] | any_2[w] | any_3[w]);
+        }
+    }
+
+    /// Количество правил
+    [[nodiscard]] size_t Size() const;
+
+    /// Количество слов uint64_t в маске правил
+    [[nodiscard]] size_t Words() const;
+
+    /// Правила в порядке добавления
+    [[nodiscard]] std::span<Rule const> Rules() const;
+
+    /// Количество невалидных строк при загрузке из файла
+    [[nodiscard]] size_t Rejected() const;
+
+private:
+    static constexpr size_t kNumOctets{4};
+    static constexpr size_t kNumValues{256};
+    static constexpr uint32_t kOctetMask{0xFF};
+    static constexpr size_t kWordBits{64};
+
+    /// Маска правил "a.b.c.d" для значения октета
+    [[nodiscard]] uint64_t const *row(size_t const octet, uint32_t const value) const {
+        return octets.data() + (octet * kNumValues + value) * words;
+    }
+
+    /// Маска правил "any==n" для значения октета
+    [[nodiscard]] uint64_t const *anyRow(uint32_t const value) const {
+        return any.data() + value * words;
+    }
+
+    /// Добавить слово маски, если новое правило в нее не помещается
+    void reserveBit();
+
+    /// Правила
+    std::vector<Rule> rules{};
+    /// Количество слов маски
+    size_t words{};
+    /// Таблицы октетов: маска [(октет * 256 + значение) * words, ... + words)
+    std::vector<uint64_t> octets{};
+    /// Таблица "any==n": маска [значение * words, ... + words)
+    std::vector<uint64_t> any{};
+    /// Количество невалидных строк
+    size_t rejected{};
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Ограниченная очередь без блокировок для одного производителя и одного потребителя
+ * @details Кольцевой буфер с атомарными индексами головы и хвоста. Push() ждет места, Pop() ждет элемента
+ * через std::atomic::wait, поэтому ожидающий поток не крутится на процессоре. Емкость ограничивает число
+ * элементов в пути между потоками (обратное давление)
+ * @tparam T Тип элемента, копируется при передаче (обычно указатель)
+ */
+template<class T>
+class SpscQueue {
+public:
+    /**
+     * @brief Конструктор
+     * @param capacity Емкость, округляется вверх до степени двойки
+     */
+    explicit SpscQueue(size_t const capacity) : slots(std::bit_ceil(std::max(capacity, size_t{1}))),
+                                                mask{slots.size() - 1} {
+    }
+
+    SpscQueue(SpscQueue const &) = delete;
+
+    SpscQueue &operator=(SpscQueue const &) = delete;
+
+    /**
+     * @brief Добавить элемент без ожидания (только производитель)
+     * @return false - Очередь заполнена
+     */
+    [[nodiscard]] bool TryPush(T const &value) {
+        size_t const cur_tail{tail.load(std::memory_order_relaxed)};
+        if (cur_tail - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[cur_tail & mask] = value;
+        tail.store(cur_tail + 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Извлечь элемент без ожидания (только потребитель)
+     * @return false - Очередь пуста
+     */
+    [[nodiscard]] bool TryPop(T &value) {
+        size_t const cur_head{head.load(std::memory_order_relaxed)};
+        if (cur_head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[cur_head & mask];
+        head.store(cur_head + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    }
+
+    /// Добавить элемент, ожидая места (только производитель)
+    void Push(T const &value) {
+        while (!TryPush(value)) {
+            head.wait(tail.load(std::memory_order_relaxed) - slots.size(), std::memory_order_acquire);
+        }
+    }
+
+    /// Извлечь элемент, ожидая его появления (только потребитель)
+    [[nodiscard]] T Pop() {
+        T value{};
+        while (!TryPop(value)) {
+            tail.wait(head.load(std::memory_order_relaxed), std::memory_order_acquire);
+        }
+        return value;
+    }
+
+private:
+    /// Размер строки кеша для разделения индексов производителя и потребителя
+    static constexpr size_t kCacheLine{64};
+
+    std::vector<T> slots;
+    size_t const mask;
+    /// Следующий извлекаемый элемент, пишет потребитель
+    alignas(kCacheLine) std::atomic<size_t> head{};
+    /// Следующее свободное место, пишет производитель
+    alignas(kCacheLine) std::atomic<size_t> tail{};
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Наибольшие k ip адресов потока
+ * @details Адреса копятся в буфере на 2k элементов. Заполненный буфер сжимается до k наибольших частичным
+ * выбором (std::nth_element, O(k)), наименьший из них становится порогом: когда k адресов уже набраны,
+ * адрес не больше порога отбрасывается одним сравнением. Память O(k) независимо от длины потока,
+ * время O(1) на адрес в среднем
+ */
+class TopK {
+public:
+    /**
+     * @brief Конструктор
+     * @param k Количество адресов, 0 - адреса не сохраняются
+     * @param unique Без повторов: одинаковые адреса считаются одним
+     * @param resource Ресурс памяти буфера
+     */
+    explicit TopK(size_t k, bool unique = false, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief Добавить ip адрес
+     * @param ip Адрес в порядке байт хоста
+     */
+    void Push(uint32_t const ip) {
+        if (full && ip <= threshold) {
+            return;
+        }
+        buffer.push_back(ip);
+        if (buffer.size() == capacity) {
+            compact();
+        }
+    }
+
+    /**
+     * @brief Наибольшие адреса по убыванию
+     * @return Не больше k адресов, без unique повторы сохраняются. Действительно до следующего Push()
+     */
+    [[nodiscard]] std::span<uint32_t const> Descending();
+
+private:
+    /// Оставить в буфере k наибольших адресов и обновить порог
+    void compact();
+
+    size_t const k;
+    bool const unique;
+    /// Размер буфера, при котором он сжимается
+    size_t const capacity;
+    /// Кандидаты, после compact() - не больше k наибольших
+    std::pmr::vector<uint32_t> buffer;
+    /// Наименьший из k наибольших адресов, если они набраны
+    uint32_t threshold{};
+    /// k адресов набраны, threshold действителен
+    bool full{};
+};
@@ -0,0 +1,129 @@
+#include <new>
+#include "arena.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+CountingResource::CountingResource(std::pmr::memory_resource *const upstream) : upstream{upstream} {
+}
+
+uint64_t CountingResource::Allocations() const {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+size_t CountingResource::InUse() const {
+    return in_use.load(std::memory_order_relaxed);
+}
+
+size_t CountingResource::Peak() const {
+    return peak.load(std::memory_order_relaxed);
+}
+
+void *CountingResource::do_allocate(size_t const bytes, size_t const alignment) {
+    void *const ptr{upstream->allocate(bytes, alignment)};
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t const now{in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes};
+    for (size_t prev{peak.load(std::memory_order_relaxed)};
+         prev < now && !peak.compare_exchange_weak(prev, now, std::memory_order_relaxed);) {
+    }
+    return ptr;
+}
+
+void CountingResource::do_deallocate(void *const ptr, size_t const bytes, size_t const alignment) {
+    upstream->deallocate(ptr, bytes, alignment);
+    in_use.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool CountingResource::do_is_equal(std::pmr::memory_resource const &other) const noexcept {
+    return this == &other;
+}
+
+HugePageResource::HugePageResource(std::pmr::memory_resource *const upstream, size_t const min_bytes) : upstream{
+        upstream}, min_bytes{min_bytes} {
+}
+
+size_t HugePageResource::MinBytes() const {
+    return min_bytes;
+}
+
+uint64_t HugePageResource::Mapped() const {
+    return mapped.load(std::memory_order_relaxed);
+}
+
+uint64_t HugePageResource::HugeTlb() const {
+    return huge_tlb.load(std::memory_order_relaxed);
+}
+
+bool HugePageResource::isMapped(size_t const bytes, size_t const alignment) const {
+#ifdef __linux__
+    static size_t const kPageSize{static_cast<size_t>(sysconf(_SC_PAGESIZE))};
+
+    return min_bytes <= bytes && alignment <= kPageSize;
+#else
+    static_cast<void>(bytes);
+    static_cast<void>(alignment);
+    return false;
+#endif
+}
+
+void *HugePageResource::do_allocate(size_t const bytes, size_t const alignment) {
+    if (!isMapped(bytes, alignment)) {
+        return upstream->allocate(bytes, alignment);
+    }
+#ifdef __linux__
+    static constexpr int kProtection{PROT_READ | PROT_WRITE};
+    static constexpr int kFlags{MAP_PRIVATE | MAP_ANONYMOUS};
+
+    size_t const size{(bytes + kHugePageSize - 1) & ~(kHugePageSize - 1)};
+    mapped.fetch_add(1, std::memory_order_relaxed);
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    if (!no_huge_tlb.load(std::memory_order_relaxed)) {
+        static constexpr int kHugePageShift{21};
+
+        void *const ptr{mmap(nullptr, size, kProtection, kFlags | MAP_HUGETLB | kHugePageShift << MAP_HUGE_SHIFT, -1, 0)};
+        if (ptr != MAP_FAILED) {
+            huge_tlb.fetch_add(1, std::memory_order_relaxed);
+            return ptr;
+        }
+        no_huge_tlb.store(true, std::memory_order_relaxed);
+    }
+#endif
+    // Отображение с запасом на выравнивание по большой странице, лишние края возвращаются
+    void *const raw{mmap(nullptr, size + kHugePageSize, kProtection, kFlags, -1, 0)};
+    if (raw == MAP_FAILED) {
+        mapped.fetch_sub(1, std::memory_order_relaxed);
+        throw std::bad_alloc{};
+    }
+    auto *const begin{static_cast<std::byte *>(raw)};
+    auto const addr{reinterpret_cast<uintptr_t>(raw)};
+    size_t const head{((addr + kHugePageSize - 1) & ~uintptr_t{kHugePageSize - 1}) - addr};
+    if (head != 0) {
+        munmap(begin, head);
+    }
+    if (kHugePageSize != head) {
+        munmap(begin + head + size, kHugePageSize - head);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(begin + head, size, MADV_HUGEPAGE);
+#endif
+    return begin + head;
+#else
+    return upstream->allocate(bytes, alignment);
+#endif
+}
+
+void HugePageResource::do_deallocate(void *const ptr, size_t const bytes, size_t const alignment) {
+    if (!isMapped(bytes, alignment)) {
+        upstream->deallocate(ptr, bytes, alignment);
+        return;
+    }
+#ifdef __linux__
+    munmap(ptr, (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1));
+#endif
+}
+
+bool HugePageResource::do_is_equal(std::pmr::memory_resource const &other) const noexcept {
+    return this == &other;
+}
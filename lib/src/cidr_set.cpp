@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <utility>
+#include "cidr_set.h"
+#include "ip_parser.h"
+#include "mapped_file.h"
+
+namespace {
+    /// Разбор строки "a.b.c.d/len" или "a.b.c.d"
+    bool parsePrefix(std::string_view const str, IpPrefix &prefix) {
+        static constexpr int kMaxLen{32};
+
+        auto const slash{str.find('/')};
+        uint32_t ip{};
+        if (IpParser::Parse(str.substr(0, slash), ip) != IpParser::Status::kOk) {
+            return false;
+        }
+        int len{kMaxLen};
+        if (slash != std::string_view::npos) {
+            std::string_view const len_str{str.substr(slash + 1)};
+            auto const [ptr, ec]{std::from_chars(len_str.data(), len_str.data() + len_str.size(), len)};
+            if (ec != std::errc{} || ptr != len_str.data() + len_str.size() || len < 0 || kMaxLen < len) {
+                return false;
+            }
+        }
+        prefix = IpPrefix{ip, len};
+        return true;
+    }
+
+    /// Строка без комментария и пробельных символов по краям
+    std::string_view trim(std::string_view str) {
+        static constexpr std::string_view kSpaces{" \t\r"};
+
+        str = str.substr(0, str.find('#'));
+        auto const beg{str.find_first_not_of(kSpaces)};
+        if (beg == std::string_view::npos) {
+            return {};
+        }
+        return str.substr(beg, str.find_last_not_of(kSpaces) - beg + 1);
+    }
+}
+
+CidrSet::CidrSet() : tbl24(size_t{1} << (32 - kTbl8Bits)) {
+}
+
+CidrSet::CidrSet(std::vector<IpPrefix> prefixes) : CidrSet{} {
+    Build(std::move(prefixes));
+}
+
+bool CidrSet::Load(std::string const &file) {
+    std::vector<IpPrefix> prefixes{};
+    size_t num_rejected{};
+    auto const add{
+        [&prefixes, &num_rejected](std::string_view const line) {
+            if (std::string_view const str{trim(line)}; !str.empty()) {
+                if (IpPrefix prefix{}; parsePrefix(str, prefix)) {
+                    prefixes.push_back(prefix);
+                } else {
+                    ++num_rejected;
+                }
+            }
+        }
+    };
+
+    if (MappedFile const mapped{file}; mapped.IsOpen()) {
+        MappedFile::ForEachLine(mapped.View(), add);
+    } else if (std::ifstream src{file}; !src.fail()) {
+        std::string line{};
+        while (std::getline(src, line)) {
+            add(line);
+        }
+    } else {
+        return false;
+    }
+    Build(std::move(prefixes));
+    rejected = num_rejected;
+    return true;
+}
+
+void CidrSet::Build(std::vector<IpPrefix> prefixes) {
+    std::ranges::fill(tbl24, 0);
+    tbl8.clear();
+    rejected = 0;
+    size = prefixes.size();
+
+    // Более длинные префиксы записываются поверх более коротких
+    std::ranges::stable_sort(prefixes, {}, &IpPrefix::length);
+    for (auto const &prefix: prefixes) {
+        insert(prefix);
+    }
+}
+
+void CidrSet::insert(IpPrefix const &prefix) {
+    static constexpr int kTbl24Len{32 - kTbl8Bits};
+
+    auto const len{static_cast<uint8_t>(prefix.length)};
+    uint32_t const first{prefix.First()};
+    uint32_t const last{prefix.Last()};
+    if (prefix.length <= kTbl24Len) {
+        // Длина 0 обозначает отсутствие префикса, поэтому /0 хранится как 1
+        std::fill(tbl24.begin() + (first >> kTbl8Bits), tbl24.begin() + (last >> kTbl8Bits) + 1,
+                  std::max<uint32_t>(len, 1));
+        return;
+    }
+
+    auto &entry{tbl24[first >> kTbl8Bits]};
+    if (!(entry & kExtended)) {
+        auto const group{static_cast<uint32_t>(tbl8.size() >> kTbl8Bits)};
+        tbl8.resize(tbl8.size() + kTbl8Size, static_cast<uint8_t>(entry));
+        entry = kExtended | group;
+    }
+    auto const beg{tbl8.begin() + ((entry & ~kExtended) << kTbl8Bits)};
+    std::fill(beg + (first & kTbl8Mask), beg + (last & kTbl8Mask) + 1, len);
+}
+
+void CidrSet::LookupBatch(std::span<uint32_t const> const ips, std::span<uint8_t> const out) const {
+    size_t i{};
+    for (; i + kBatchSize <= ips.size(); i += kBatchSize) {
+        uint32_t entries[kBatchSize];
+        for (size_t j{}; j < kBatchSize; ++j) {
+            entries[j] = tbl24[ips[i + j] >> kTbl8Bits];
+        }
+        for (size_t j{}; j < kBatchSize; ++j) {
+            out[i + j] = resolve(entries[j], ips[i + j]);
+        }
+    }
+    for (; i < ips.size(); ++i) {
+        out[i] = Lookup(ips[i]);
+    }
+}
+
+size_t CidrSet::Size() const {
+    return size;
+}
+
+size_t CidrSet::Rejected() const {
+    return rejected;
+}
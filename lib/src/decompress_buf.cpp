@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "decompress_buf.h"
+
+#ifdef IP_FILTER_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef IP_FILTER_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+DecompressBuf::Format DecompressBuf::Detect(std::string_view const data) {
+    static constexpr std::string_view kGzipMagic{"\x1F\x8B"};
+    static constexpr std::string_view kZstdMagic{"\x28\xB5\x2F\xFD"};
+
+    if (data.starts_with(kGzipMagic)) {
+        return Format::kGzip;
+    }
+    if (data.starts_with(kZstdMagic)) {
+        return Format::kZstd;
+    }
+    return Format::kPlain;
+}
+
+bool DecompressBuf::Supported(Format const format) {
+    switch (format) {
+        case Format::kPlain:
+            return true;
+        case Format::kGzip:
+#ifdef IP_FILTER_WITH_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Format::kZstd:
+#ifdef IP_FILTER_WITH_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+std::vector<std::string_view> DecompressBuf::ZstdFrames(std::string_view data) {
+    std::vector<std::string_view> frames{};
+#ifdef IP_FILTER_WITH_ZSTD
+    while (!data.empty()) {
+        size_t const size{ZSTD_findFrameCompressedSize(data.data(), data.size())};
+        if (ZSTD_isError(size) != 0) {
+            return {};
+        }
+        frames.push_back(data.substr(0, size));
+        data.remove_prefix(size);
+    }
+#else
+    static_cast<void>(data);
+#endif
+    return frames;
+}
+
+DecompressBuf::DecompressBuf(std::string_view const compressed, Format const format) : input{compressed},
+    format{format} {
+    if (!Supported(format)) {
+        error = true;
+        finished = true;
+        return;
+    }
+#ifdef IP_FILTER_WITH_ZLIB
+    if (format == Format::kGzip) {
+        static constexpr int kGzipWindowBits{15 + 16};
+
+        auto *const stream{new z_stream{}};
+        if (inflateInit2(stream, kGzipWindowBits) != Z_OK) {
+            delete stream;
+            error = true;
+            finished = true;
+            return;
+        }
+        state = stream;
+    }
+#endif
+#ifdef IP_FILTER_WITH_ZSTD
+    if (format == Format::kZstd) {
+        state = ZSTD_createDCtx();
+        if (state == nullptr) {
+            error = true;
+            finished = true;
+        }
+    }
+#endif
+}
+
+DecompressBuf::~DecompressBuf() {
+#ifdef IP_FILTER_WITH_ZLIB
+    if (format == Format::kGzip && state != nullptr) {
+        auto *const stream{static_cast<z_stream *>(state)};
+        inflateEnd(stream);
+        delete stream;
+    }
+#endif
+#ifdef IP_FILTER_WITH_ZSTD
+    if (format == Format::kZstd && state != nullptr) {
+        ZSTD_freeDCtx(static_cast<ZSTD_DCtx *>(state));
+    }
+#endif
+}
+
+bool DecompressBuf::Good() const {
+    return !error;
+}
+
+DecompressBuf::int_type DecompressBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    buffer.resize(kBufferSize);
+    size_t const size{decode(buffer.data(), buffer.size())};
+    if (size == 0) {
+        return traits_type::eof();
+    }
+    setg(buffer.data(), buffer.data(), buffer.data() + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize DecompressBuf::xsgetn(char *const out, std::streamsize const size) {
+    // Сначала остаток буфера underflow, затем распаковка сразу в буфер вызывающего
+    auto const buffered{std::min(size, static_cast<std::streamsize>(egptr() - gptr()))};
+    if (buffered != 0) {
+        std::memcpy(out, gptr(), static_cast<size_t>(buffered));
+        gbump(static_cast<int>(buffered));
+    }
+    auto total{static_cast<size_t>(buffered)};
+    while (total < static_cast<size_t>(size)) {
+        size_t const decoded{decode(out + total, static_cast<size_t>(size) - total)};
+        if (decoded == 0) {
+            break;
+        }
+        total += decoded;
+    }
+    return static_cast<std::streamsize>(total);
+}
+
+size_t DecompressBuf::decode(char *const out, size_t const size) {
+    if (finished) {
+        return 0;
+    }
+    switch (format) {
+        case Format::kPlain: {
+            size_t const copied{std::min(size, input.size() - consumed)};
+            std::memcpy(out, input.data() + consumed, copied);
+            consumed += copied;
+            finished = consumed == input.size();
+            return copied;
+        }
+        case Format::kGzip:
+            return decodeGzip(out, size);
+        case Format::kZstd:
+            return decodeZstd(out, size);
+    }
+    return 0;
+}
+
+size_t DecompressBuf::decodeGzip(char *const out, size_t const size) {
+#ifdef IP_FILTER_WITH_ZLIB
+    auto *const stream{static_cast<z_stream *>(state)};
+    stream->next_out = reinterpret_cast<Bytef *>(out);
+    stream->avail_out = static_cast<uInt>(std::min(size, size_t{UINT_MAX}));
+    uInt const avail{stream->avail_out};
+    while (stream->avail_out != 0 && !finished) {
+        if (stream->avail_in == 0) {
+            if (consumed == input.size()) {
+                // Данные закончились внутри члена gzip
+                error = true;
+                finished = true;
+                break;
+            }
+            size_t const chunk{std::min(input.size() - consumed, size_t{UINT_MAX})};
+            stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data() + consumed));
+            stream->avail_in = static_cast<uInt>(chunk);
+            consumed += chunk;
+        }
+        if (int const status{inflate(stream, Z_NO_FLUSH)}; status == Z_STREAM_END) {
+            // Следующий член gzip, если данные не закончились
+            if (stream->avail_in == 0 && consumed == input.size()) {
+                finished = true;
+            } else {
+                inflateReset(stream);
+            }
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            error = true;
+            finished = true;
+        }
+    }
+    return avail - stream->avail_out;
+#else
+    static_cast<void>(out);
+    static_cast<void>(size);
+    return 0;
+#endif
+}
+
+size_t DecompressBuf::decodeZstd(char *const out, size_t const size) {
+#ifdef IP_FILTER_WITH_ZSTD
+    auto *const context{static_cast<ZSTD_DCtx *>(state)};
+    ZSTD_outBuffer output{out, size, 0};
+    while (output.pos < output.size && !finished) {
+        ZSTD_inBuffer in{input.data(), input.size(), consumed};
+        size_t const status{ZSTD_decompressStream(context, &output, &in)};
+        consumed = in.pos;
+        if (ZSTD_isError(status) != 0) {
+            error = true;
+            finished = true;
+        } else if (consumed == input.size() && output.pos < output.size) {
+            // Вход закончился и вывод сброшен: 0 - последний кадр завершен, иначе данные обрезаны
+            error = status != 0;
+            finished = true;
+        }
+    }
+    return output.pos;
+#else
+    static_cast<void>(out);
+    static_cast<void>(size);
+    return 0;
+#endif
+}
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <limits>
+#include "external_sort.h"
+#include "radix_sort.h"
+
+namespace {
+    /// Переход к байту offset: long на Windows 32-битный, поэтому смещение 64-битное
+    bool seek(std::FILE *const file, uint64_t const offset) {
+#ifdef WINDOWS_SPECIFIC_FLAG
+        using offset_t = __int64;
+#else
+        using offset_t = off_t;
+#endif
+        if (offset > static_cast<uint64_t>(std::numeric_limits<offset_t>::max())) {
+            return false;
+        }
+#ifdef WINDOWS_SPECIFIC_FLAG
+        return _fseeki64(file, static_cast<offset_t>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<offset_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+SpillFile::SpillFile() : file{std::tmpfile()}, failed{!file} {
+}
+
+bool SpillFile::Good() const {
+    return !failed;
+}
+
+void SpillFile::Write(std::span<uint32_t const> const ips) {
+    flush();
+    if (file && std::fwrite(ips.data(), sizeof(uint32_t), ips.size(), file.get()) != ips.size()) {
+        failed = true;
+    }
+    size += ips.size();
+}
+
+void SpillFile::Rewind() {
+    flush();
+    buffer = {};
+    if (file) {
+        std::rewind(file.get());
+    }
+}
+
+size_t SpillFile::Size() const {
+    return size + buffer.size();
+}
+
+size_t SpillFile::Read(std::span<uint32_t> const out) {
+    if (!file) {
+        return 0;
+    }
+    return std::fread(out.data(), sizeof(uint32_t), out.size(), file.get());
+}
+
+size_t SpillFile::Read(size_t const offset, std::span<uint32_t> const out) {
+    flush();
+    if (!file || offset > std::numeric_limits<uint64_t>::max() / sizeof(uint32_t) ||
+        !seek(file.get(), offset * sizeof(uint32_t))) {
+        failed = true;
+        return 0;
+    }
+    return Read(out);
+}
+
+void SpillFile::flush() {
+    if (buffer.empty()) {
+        return;
+    }
+    if (file && std::fwrite(buffer.data(), sizeof(uint32_t), buffer.size(), file.get()) != buffer.size()) {
+        failed = true;
+    }
+    size += buffer.size();
+    buffer.clear();
+}
+
+ExternalSort::ExternalSort(size_t const max_memory) : max_memory{max_memory},
+    run_size{std::max(max_memory / (2 * sizeof(uint32_t)), kMinBufferSize)} {
+    run.reserve(run_size);
+}
+
+void ExternalSort::Finish() {
+    static constexpr auto kKey{[](uint32_t const ip) { return ip; }};
+
+    if (!file) {
+        RadixSort::Descending(run, kKey);
+        run_pos = 0;
+        return;
+    }
+    if (!run.empty()) {
+        spill();
+    }
+    run = {};
+    file->Rewind();
+
+    // Промежуточные проходы: каждые kMaxFanIn серий сливаются в одну серию нового файла
+    while (bounds.size() > kMaxFanIn) {
+        auto merged{std::make_unique<SpillFile>()};
+        std::vector<std::pair<size_t, size_t> > merged_bounds{};
+        merged_bounds.reserve((bounds.size() + kMaxFanIn - 1) / kMaxFanIn);
+        for (size_t first{}; first < bounds.size(); first += kMaxFanIn) {
+            startMerge(first, std::min(first + kMaxFanIn, bounds.size()));
+            size_t const offset{merged->Size()};
+            for (uint32_t ip{}; pop(ip);) {
+                merged->Write(ip);
+            }
+            merged_bounds.emplace_back(offset, merged->Size() - offset);
+        }
+        merged->Rewind();
+        good = good && merged->Good();
+        file = std::move(merged);
+        bounds = std::move(merged_bounds);
+        ++num_passes;
+    }
+    startMerge(0, bounds.size());
+}
+
+bool ExternalSort::Next(uint32_t &ip) {
+    if (!file) {
+        if (run_pos < run.size()) {
+            ip = run[run_pos++];
+            return true;
+        }
+        return false;
+    }
+    return pop(ip);
+}
+
+bool ExternalSort::Good() const {
+    return good;
+}
+
+size_t ExternalSort::NumRuns() const {
+    return num_runs;
+}
+
+size_t ExternalSort::NumPasses() const {
+    return num_passes;
+}
+
+void ExternalSort::spill() {
+    RadixSort::Descending(run, [](uint32_t const ip) { return ip; });
+    if (!file) {
+        file = std::make_unique<SpillFile>();
+    }
+    bounds.emplace_back(file->Size(), run.size());
+    file->Write(run);
+    good = good && file->Good();
+    ++num_runs;
+    run.clear();
+}
+
+void ExternalSort::startMerge(size_t const first, size_t const last) {
+    size_t const count{last - first};
+    size_t const buffer_size{std::max(max_memory / sizeof(uint32_t) / std::max(count, size_t{1}), kMinBufferSize)};
+    buffers.resize(count);
+    for (auto &buffer: buffers) {
+        buffer.resize(buffer_size);
+        buffer.shrink_to_fit();
+    }
+    cursors.assign(count, {});
+    heap.clear();
+    for (size_t i{}; i < count; ++i) {
+        cursors[i].offset = bounds[first + i].first;
+        cursors[i].end = bounds[first + i].first + bounds[first + i].second;
+        if (refill(i)) {
+            heap.emplace_back(buffers[i].front(), i);
+        }
+    }
+    std::ranges::make_heap(heap);
+}
+
+bool ExternalSort::pop(uint32_t &ip) {
+    if (heap.empty()) {
+        return false;
+    }
+    std::ranges::pop_heap(heap);
+    auto const [value, index]{heap.back()};
+    heap.pop_back();
+    ip = value;
+
+    auto &cursor{cursors[index]};
+    if (++cursor.pos < cursor.size || refill(index)) {
+        heap.emplace_back(buffers[index][cursor.pos], index);
+        std::ranges::push_heap(heap);
+    }
+    return true;
+}
+
+bool ExternalSort::refill(size_t const index) {
+    auto &cursor{cursors[index]};
+    if (cursor.offset == cursor.end) {
+        return false;
+    }
+    auto const out{std::span{buffers[index]}.first(std::min(buffers[index].size(), cursor.end - cursor.offset))};
+    size_t const size{file->Read(cursor.offset, out)};
+    good = good && size != 0;
+    cursor.offset += size;
+    cursor.pos = 0;
+    cursor.size = size;
+    return size != 0;
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <tuple>
+#include <boost/asio/ip/address_v4.hpp>
+#include "ip_aggregator.h"
+
+namespace {
+    /// Разбор счетчика до табуляции или конца строки
+    bool parse_counter(std::string_view &rest, uint64_t &value) {
+        if (rest.empty() || rest.front() != '\t') {
+            return false;
+        }
+        rest.remove_prefix(1);
+        auto const [ptr, ec]{std::from_chars(rest.data(), rest.data() + rest.size(), value)};
+        if (ec != std::errc{} || ptr == rest.data()) {
+            return false;
+        }
+        rest.remove_prefix(static_cast<size_t>(ptr - rest.data()));
+        return true;
+    }
+}
+
+IpAggregator::IpAggregator(int const prefix_length) : mask{IpPrefix{0, prefix_length}.Mask()},
+    prefix_length{prefix_length}, slots(kMinCapacity) {
+}
+
+bool IpAggregator::AddLine(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    uint32_t ip{};
+    auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+    return AddLine(line, status, ip);
+}
+
+bool IpAggregator::AddLine(std::string_view line, IpParser::Status const status, uint32_t const ip) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::string_view rest{line.substr(IpParser::FirstField(line).size())};
+    uint64_t requests{};
+    uint64_t bytes{};
+    if (status != IpParser::Status::kOk ||
+        !parse_counter(rest, requests) || !parse_counter(rest, bytes) || !(rest.empty() || rest.front() == '\t')) {
+        ++rejected;
+        return false;
+    }
+    Add(ip, requests, bytes);
+    return true;
+}
+
+void IpAggregator::Add(uint32_t const ip, uint64_t const requests, uint64_t const bytes) {
+    Slot &slot{find(ip & mask)};
+    if (!slot.used) {
+        slot = {ip & mask, true};
+        // Заполнение не больше половины таблицы
+        if (2 * ++size > slots.size()) {
+            grow();
+            Slot &moved{find(ip & mask)};
+            moved.requests += requests;
+            moved.bytes += bytes;
+            return;
+        }
+    }
+    slot.requests += requests;
+    slot.bytes += bytes;
+}
+
+void IpAggregator::Merge(IpAggregator const &other) {
+    for (auto const &slot: other.slots) {
+        if (slot.used) {
+            Add(slot.key, slot.requests, slot.bytes);
+        }
+    }
+    rejected += other.rejected;
+}
+
+std::vector<IpAggregator::Entry> IpAggregator::Top(size_t const num) const {
+    std::vector<Entry> entries{};
+    entries.reserve(size);
+    for (auto const &slot: slots) {
+        if (slot.used) {
+            entries.push_back({{slot.key, prefix_length}, slot.requests, slot.bytes});
+        }
+    }
+    auto const greater{[](Entry const &lhs, Entry const &rhs) {
+        return std::tie(lhs.requests, lhs.bytes, lhs.prefix.value) > std::tie(rhs.requests, rhs.bytes, rhs.prefix.value);
+    }};
+    auto const middle{entries.begin() + static_cast<std::ptrdiff_t>(std::min(num, entries.size()))};
+    std::ranges::partial_sort(entries, middle, greater);
+    entries.erase(middle, entries.end());
+    return entries;
+}
+
+std::string IpAggregator::Format(Entry const &entry) {
+    return boost::asio::ip::address_v4{entry.prefix.value}.to_string() + '/' + std::to_string(entry.prefix.length) +
+           '\t' + std::to_string(entry.requests) + '\t' + std::to_string(entry.bytes);
+}
+
+int IpAggregator::PrefixLength() const {
+    return prefix_length;
+}
+
+size_t IpAggregator::Size() const {
+    return size;
+}
+
+size_t IpAggregator::Rejected() const {
+    return rejected;
+}
+
+IpAggregator::Slot &IpAggregator::find(uint32_t const key) {
+    static constexpr uint64_t kGolden{0x9E3779B97F4A7C15};
+
+    size_t const index_mask{slots.size() - 1};
+    // Хеш Фибоначчи: старшие биты произведения, адреса одного префикса не попадают в соседние ячейки
+    size_t index{static_cast<size_t>(key * kGolden >> (64 - std::countr_zero(slots.size())))};
+    while (slots[index].used && slots[index].key != key) {
+        index = (index + 1) & index_mask;
+    }
+    return slots[index];
+}
+
+void IpAggregator::grow() {
+    std::vector<Slot> old(slots.size() * 2);
+    old.swap(slots);
+    for (auto const &slot: old) {
+        if (slot.used) {
+            find(slot.key) = slot;
+        }
+    }
+}
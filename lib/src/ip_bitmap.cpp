@@ -0,0 +1,49 @@
+#include "ip_bitmap.h"
+
+IpBitmap::IpBitmap(bool const counting) : blocks(kNumBlocks), counting{counting} {
+}
+
+std::unique_ptr<IpBitmap::Block> IpBitmap::allocate() {
+    return std::make_unique<Block>();
+}
+
+size_t IpBitmap::Density(std::span<uint32_t const> const ips) {
+    std::vector<bool> touched(kNumBlocks);
+    size_t num_blocks{};
+    for (uint32_t const ip: ips) {
+        if (!touched[ip >> kBlockBits]) {
+            touched[ip >> kBlockBits] = true;
+            ++num_blocks;
+        }
+    }
+    return num_blocks == 0 ? 0 : ips.size() / num_blocks;
+}
+
+uint32_t IpBitmap::count(uint32_t const ip) const {
+    if (!counting || repeats.empty()) {
+        return 1;
+    }
+    auto const it{repeats.find(ip)};
+    return it == repeats.end() ? 1 : 1 + it->second;
+}
+
+uint32_t IpBitmap::Count(uint32_t const ip) const {
+    return Contains(ip) ? count(ip) : 0;
+}
+
+bool IpBitmap::Contains(uint32_t const ip) const {
+    auto const &block{blocks[ip >> kBlockBits]};
+    return block && test(*block, ip & kLowMask);
+}
+
+size_t IpBitmap::Size() const {
+    return num_total;
+}
+
+size_t IpBitmap::Unique() const {
+    return num_unique;
+}
+
+bool IpBitmap::Counting() const {
+    return counting;
+}
@@ -1,221 +1,1112 @@
+#include <array>
+#include <cstring>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <string>
 #include <utility>
 #include <vector>
-#include <tuple>
-#include <sstream>
+#include "arena.h"
+#include "external_sort.h"
 #include "ip_filter.h"
+#include "mapped_file.h"
+#include "spsc_queue.h"
 
-void IpFilter::parsing_cxx17(std::string const &line) {
-    static constexpr int kMaxSizeIpString{16};
-    static constexpr int kNumIpElements{4};
+#ifndef WINDOWS_SPECIFIC_FLAG
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 
-    if (auto const beg_tab{std::find(line.cbegin(), line.cend(), '\t')}; beg_tab != line.cend()) {
-        size_t const len_ip_str{static_cast<size_t>(std::distance(line.cbegin(), beg_tab))};
-        if (kMaxSizeIpString < len_ip_str) {
-        } else if (auto const ip_elements{splitString(line.substr(0, len_ip_str), '.')};
-            kNumIpElements != ip_elements.size()) {
-        } else {
-            ips_cxx17.emplace_back(parsingIpElements(ip_elements));
-        }
+IpParser::Status IpFilter::parsing_cxx17(std::string_view const line, std::pmr::vector<uint32_t> &ips) {
+    uint32_t ip_addr{};
+    auto const status{IpParser::Parse(IpParser::FirstField(line), ip_addr)};
+    if (status == IpParser::Status::kOk) {
+        ips.push_back(ip_addr);
     }
+    return status;
 }
 
-std::tuple<std::string, uint32_t> IpFilter::parsingIpElements(std::vector<std::string> const &ip_elements) {
-    static constexpr int kStep{8};
-    static constexpr int kMaxNumPoint{3};
+IpFilter::IpFilter(std::string file, std::string const &out, int const standard,
+                   std::pmr::memory_resource *const resource) : file{std::move(file)}, counting{resource}, dst{out},
+    standard{standard} {
+}
 
-    std::string ip_str{};
-    uint32_t ip_addr{};
-    for (size_t i{}, shift{24}; i < ip_elements.size(); ++i, shift -= kStep) {
-        auto const &elm{ip_elements[i]};
-        if (i < kMaxNumPoint) {
-            ip_str.append(elm + '.');
-        } else {
-            ip_str.append(elm);
+uint64_t IpFilter::Version() {
+    return PROJECT_VERSION_PATCH;
+}
+
+bool IpFilter::Parsing() {
+    stats = {};
+    uint64_t const allocations{counting.Allocations()};
+    PhaseClock const clock{};
+    bool parsed{true};
+    indexed = false;
+    read_error = false;
+    if (limit != 0 && (standard == kCxx17 || standard == kCxx23)) {
+        parsed = parsingLimit();
+    } else if (loadIndex()) {
+        parsed = parsingIndex();
+    } else if (max_memory != 0 && (standard == kCxx17 || standard == kCxx23)) {
+        parsed = parsingExternal();
+    } else if (storage == Storage::kBitmap && (standard == kCxx17 || standard == kCxx23)) {
+        parsed = parsingBitmap();
+    } else {
+        switch (standard) {
+            case kCxx17:
+                parsed = parsingCxx17();
+                break;
+            case kCxx23:
+                parsed = parsingCxx23();
+                break;
+            default:
+                std::cout << "Unknows standart=" << standard << '\n';
+                return false;
         }
-        ip_addr |= std::stol(elm) << shift;
     }
-    return std::make_tuple(ip_str, ip_addr);
+    // Фазы замеряются целиком, загрузка страниц входит в parse
+    stats.phases.parse -= stats.phases.read;
+    finishStats(clock, allocations);
+    return parsed && !read_error && written();
+}
+
+void IpFilter::finishStats(PhaseClock const &clock, uint64_t const allocations) {
+    // Запись вывода входит в filter
+    stats.phases.write = dst.WriteTime();
+    stats.phases.filter -= stats.phases.write;
+    stats.phases.total = clock.Total();
+    stats.allocations = counting.Allocations() - allocations;
+    stats.peak_bytes = counting.Peak();
+    stats.max_rss_kb = MaxRssKb();
 }
 
-void IpFilter::print(std::string const &str) {
-    if (dst.is_open()) {
-        dst << str << '\n';
+void IpFilter::Feed(std::span<char const> const chunk) {
+    if (!feed_clock) {
+        stats = {};
+        feed_allocations = counting.Allocations();
+        feed_clock.emplace();
+        ips.clear();
+        feed_tail.clear();
+        indexed = false;
+        if (aggregator) {
+            int const prefix_length{aggregator->PrefixLength()};
+            aggregator.emplace(prefix_length);
+        }
+    }
+    PhaseClock clock{};
+    stats.bytes += chunk.size();
+    std::string_view text{chunk.data(), chunk.size()};
+    // Конец строки, начатой в предыдущих частях
+    if (!feed_tail.empty()) {
+        auto const eol{text.find('\n')};
+        feed_tail.append(text.substr(0, eol));
+        if (eol == std::string_view::npos) {
+            clock.Mark(stats.phases.parse);
+            return;
+        }
+        feedLine(feed_tail);
+        feed_tail.clear();
+        text.remove_prefix(eol + 1);
+    }
+    // Целые строки разбираются на месте, неполная последняя строка сохраняется до следующей части
+    auto const last_eol{text.rfind('\n')};
+    if (last_eol == std::string_view::npos) {
+        feed_tail.assign(text);
     } else {
-        std::cout << str << '\n';
+        MappedFile::ForEachLine(text.substr(0, last_eol + 1), [this](std::string_view const line) { feedLine(line); });
+        feed_tail.assign(text.substr(last_eol + 1));
     }
+    clock.Mark(stats.phases.parse);
 }
 
-IpFilter::IpFilter(std::string file, std::string const &out, int const standard) : file{std::move(file)}, dst{out},
-    standard{standard} {
+void IpFilter::feedLine(std::string_view const line) {
+    uint32_t ip{};
+    auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+    countLine(stats, status);
+    if (status == IpParser::Status::kOk) {
+        ips.push_back(ip);
+    }
+    if (aggregator) {
+        aggregator->AddLine(line, status, ip);
+    }
 }
 
-uint64_t IpFilter::Version() {
-    return PROJECT_VERSION_PATCH;
+bool IpFilter::Finish() {
+    if (!feed_clock) {
+        Feed({});
+    }
+    PhaseClock clock{};
+    if (!feed_tail.empty()) {
+        feedLine(feed_tail);
+        feed_tail.clear();
+    }
+    clock.Mark(stats.phases.parse);
+    RadixSort::Descending(ips, std::identity{}, threads);
+    sorted_descending = true;
+    if (unique) {
+        ips.erase(std::ranges::unique(ips).begin(), ips.end());
+    }
+    clock.Mark(stats.phases.sort);
+    filterSorted();
+    clock.Mark(stats.phases.filter);
+    finishStats(*feed_clock, feed_allocations);
+    feed_clock.reset();
+    return written();
 }
 
-bool IpFilter::isAllDigits(std::string const &str) {
-    for (char ch: str) {
-        if (!std::isdigit(ch)) {
-            return false;
+void IpFilter::SetSink(Sink output) {
+    sink = std::move(output);
+}
+
+uint64_t &IpFilter::matchesOf(Section const output_section) {
+    switch (output_section) {
+        case Section::kTask1:
+            return stats.matches.task_1;
+        case Section::kTask2:
+            return stats.matches.task_2;
+        case Section::kTask3:
+            return stats.matches.task_3;
+        case Section::kTask4:
+            return stats.matches.task_4;
+        case Section::kCidr:
+            break;
+    }
+    return stats.matches.cidr;
+}
+
+template<class Func>
+void IpFilter::forEachLine(Func &&func) {
+    MappedFile const mapped{file};
+    if (auto const format{DecompressBuf::Detect(mapped.View())}; format != DecompressBuf::Format::kPlain) {
+        DecompressBuf decompressed{mapped.View(), format};
+        std::istream src{&decompressed};
+        stats.bytes += forEachStreamLine(src, false, func).bytes;
+        read_error = read_error || !decompressed.Good();
+    } else if (mapped.IsOpen()) {
+        prefault(mapped);
+        MappedFile::ForEachLine(mapped.View(), func);
+    } else if (std::ifstream src{file}; !src.fail()) {
+        std::string line{};
+        while (std::getline(src, line)) {
+            stats.bytes += line.size() + 1;
+            func(std::string_view{line});
+        }
+    } else if (file.empty()) {
+        std::string line{};
+        while (std::getline(std::cin, line)) {
+            stats.bytes += line.size() + 1;
+            func(std::string_view{line});
         }
+    } else {
+        read_error = true;
+    }
+}
+
+void IpFilter::prefault(MappedFile const &mapped) {
+    stats.bytes += mapped.View().size();
+    if (collect_stats) {
+        PhaseClock clock{};
+        mapped.Prefault();
+        clock.Mark(stats.phases.read);
     }
-    return true;
 }
 
-std::vector<std::string> IpFilter::splitString(std::string const &str, char const delimiter) {
-    std::vector<std::string> tokens;
-    std::istringstream iss(str);
-    std::string token;
+template<class Parse>
+void IpFilter::readLines(Parse parse) {
+    // Адрес разобранной строки - последний добавленный в вектор
+    auto const parse_part{[this, &parse](std::string_view const line, Part &part) {
+        auto const status{parse(line, part.ips)};
+        countLine(part.stats, status);
+        if (part.aggregator) {
+            part.aggregator->AddLine(line, status, status == IpParser::Status::kOk ? part.ips.back() : 0);
+        }
+    }};
+    auto const parse_line{[this, &parse](std::string_view const line) {
+        auto const status{parse(line, ips)};
+        countLine(stats, status);
+        if (aggregator) {
+            aggregator->AddLine(line, status, status == IpParser::Status::kOk ? ips.back() : 0);
+        }
+    }};
 
-    while (std::getline(iss, token, delimiter)) {
-        if (isAllDigits(token)) {
-            tokens.push_back(token);
+    MappedFile const mapped{file};
+    if (auto const format{DecompressBuf::Detect(mapped.View())}; format != DecompressBuf::Format::kPlain) {
+        readCompressed(mapped.View(), format, parse_part);
+        return;
+    }
+    if (threads <= 1) {
+        // Контейнер резервируется по оценке числа строк отображенного файла, без удвоений емкости при росте
+        if (mapped.IsOpen()) {
+            ips.reserve(ips.size() + MappedFile::EstimateLines(mapped.View()));
         }
+        forEachLine(parse_line);
+        return;
     }
+    if (!mapped.IsOpen()) {
+        if (file.empty()) {
+            readStream(std::cin, threads, parse_part);
+        } else if (std::ifstream src{file}; !src.fail()) {
+            readStream(src, threads, parse_part);
+        } else {
+            read_error = true;
+        }
+        return;
+    }
+    auto const texts{MappedFile::SplitLines(mapped.View(), threads)};
+    if (texts.size() <= 1) {
+        forEachLine(parse_line);
+        return;
+    }
+    prefault(mapped);
+    // Части разбираются в арены (по одной на поток) и после объединения освобождаются целиком.
+    // Контейнер части резервируется по оценке числа строк в потоке части, поэтому не растет внутри арены
+    std::vector<std::unique_ptr<Arena<> > > arenas{};
+    std::vector<Part> parts{};
+    parts.reserve(texts.size());
+    for (size_t i{}; i < texts.size(); ++i) {
+        addPart(parts, arenas.emplace_back(std::make_unique<Arena<> >(&counting)).get());
+    }
+    {
+        std::vector<std::jthread> workers{};
+        for (size_t i{}; i < texts.size(); ++i) {
+            workers.emplace_back([&text = texts[i], &part = parts[i], &parse_part] {
+                part.ips.reserve(MappedFile::EstimateLines(text));
+                MappedFile::ForEachLine(text, [&](std::string_view const line) { parse_part(line, part); });
+            });
+        }
+    }
+    mergeParts(parts);
+}
 
-    return tokens;
+void IpFilter::addPart(std::vector<Part> &parts, std::pmr::memory_resource *const resource) const {
+    auto &part{parts.emplace_back(resource)};
+    if (aggregator) {
+        part.aggregator.emplace(aggregator->PrefixLength());
+    }
 }
 
-bool IpFilter::Parsing() {
-    switch (standard) {
-        case kCxx17:
-            if (!parsingCxx17()) {
-                return false;
+void IpFilter::mergeParts(std::vector<Part> &parts) {
+    size_t total{ips.size()};
+    for (auto const &part: parts) {
+        total += part.ips.size();
+    }
+    ips.reserve(total);
+    for (auto const &part: parts) {
+        ips.insert(ips.end(), part.ips.begin(), part.ips.end());
+        if (part.aggregator) {
+            aggregator->Merge(*part.aggregator);
+        }
+        stats.Merge(part.stats);
+    }
+}
+
+template<class ParsePart>
+void IpFilter::readStream(std::istream &src, size_t const num_workers, ParsePart const &parse_part) {
+    /// Блок входных данных: буфер и занятый размер
+    struct Block {
+        std::vector<char> data{};
+        size_t size{};
+    };
+
+    std::vector<Part> parts{};
+    parts.reserve(num_workers);
+    std::vector<Block> blocks(num_workers * kPipelineBlocks);
+    // Очереди рабочего потока: заполненные блоки от читателя и свободные блоки обратно, nullptr - конец
+    std::vector<std::unique_ptr<SpscQueue<Block *> > > filled{};
+    std::vector<std::unique_ptr<SpscQueue<Block *> > > released{};
+    for (size_t i{}; i < num_workers; ++i) {
+        addPart(parts, &counting);
+        filled.push_back(std::make_unique<SpscQueue<Block *> >(kPipelineBlocks));
+        released.push_back(std::make_unique<SpscQueue<Block *> >(kPipelineBlocks));
+        for (size_t j{}; j < kPipelineBlocks; ++j) {
+            released.back()->Push(&blocks[i * kPipelineBlocks + j]);
+        }
+    }
+    std::vector<std::jthread> workers{};
+    for (size_t i{}; i < num_workers; ++i) {
+        workers.emplace_back([&part = parts[i], &to_parse = *filled[i], &to_read = *released[i], &parse_part] {
+            for (Block *block{}; (block = to_parse.Pop()) != nullptr; to_read.Push(block)) {
+                MappedFile::ForEachLine(std::string_view{block->data.data(), block->size},
+                                        [&](std::string_view const line) { parse_part(line, part); });
             }
-            break;
-        case kCxx23:
-            if (!parsingCxx23()) {
-                return false;
+        });
+    }
+    // Неполная последняя строка прочитанного блока
+    std::string carry{};
+    for (size_t i{}; ; i = (i + 1) % num_workers) {
+        Block &block{*released[i]->Pop()};
+        block.data.resize(std::max(block.data.size(), carry.size() + kPipelineBlockSize));
+        block.size = static_cast<size_t>(std::ranges::copy(carry, block.data.begin()).out - block.data.begin());
+        // Конец последней полной строки блока, 0 - перевода строки еще нет
+        size_t end{};
+        bool more{true};
+        while (more && end == 0) {
+            block.data.resize(std::max(block.data.size(), block.size + kPipelineBlockSize));
+            src.read(block.data.data() + block.size, static_cast<std::streamsize>(kPipelineBlockSize));
+            auto const read_beg{block.data.begin() + static_cast<std::ptrdiff_t>(block.size)};
+            block.size += static_cast<size_t>(src.gcount());
+            auto const read_end{block.data.begin() + static_cast<std::ptrdiff_t>(block.size)};
+            if (auto const eol{std::find(std::make_reverse_iterator(read_end), std::make_reverse_iterator(read_beg), '\n')};
+                eol.base() != read_beg) {
+                end = static_cast<size_t>(eol.base() - block.data.begin());
             }
+            more = src.good();
+        }
+        if (!more) {
+            end = block.size;
+        }
+        carry.assign(block.data.data() + end, block.size - end);
+        block.size = end;
+        stats.bytes += end;
+        filled[i]->Push(&block);
+        if (!more) {
             break;
-        default:
-            std::cout << "Unknows standart=" << standard << '\n';
-            return false;
+        }
     }
-    return true;
+    for (auto const &queue: filled) {
+        queue->Push(nullptr);
+    }
+    workers.clear();
+    mergeParts(parts);
 }
 
-bool IpFilter::parsingCxx23() {
-    bool ret{};
-    if (std::ifstream src{file}; !src.fail()) {
-        std::string line{};
-        while (std::getline(src, line)) {
-            parsing_cxx23(line);
+template<class ParsePart>
+void IpFilter::readCompressed(std::string_view const compressed, DecompressBuf::Format const format,
+                              ParsePart const &parse_part) {
+    auto const frames{format == DecompressBuf::Format::kZstd && threads > 1
+                          ? DecompressBuf::ZstdFrames(compressed)
+                          : std::vector<std::string_view>{}};
+    if (frames.size() <= 1) {
+        DecompressBuf decompressed{compressed, format};
+        std::istream src{&decompressed};
+        readStream(src, threads, parse_part);
+        read_error = read_error || !decompressed.Good();
+        return;
+    }
+    // Группы соседних кадров примерно равного сжатого размера, по одной на поток
+    size_t const num_groups{std::min<size_t>(threads, frames.size())};
+    std::vector<std::string_view> groups{};
+    for (size_t i{}, beg{}; i < num_groups; ++i) {
+        size_t end{beg + 1};
+        size_t const target{compressed.size() * (i + 1) / num_groups};
+        while (end < frames.size() - (num_groups - i - 1) &&
+               static_cast<size_t>(frames[end - 1].data() + frames[end - 1].size() - compressed.data()) < target) {
+            ++end;
         }
-        Sorting(std::greater{});
-        filter(Otus::task_1, Otus::task_2, Otus::task_3, Otus::task_4);
-        ret = true;
-    } else {
-        std::string line{};
-        while (std::getline(std::cin, line)) {
-            parsing_cxx23(line);
+        if (i + 1 == num_groups) {
+            end = frames.size();
+        }
+        groups.emplace_back(frames[beg].data(),
+                            static_cast<size_t>(frames[end - 1].data() + frames[end - 1].size() - frames[beg].data()));
+        beg = end;
+    }
+    std::vector<Part> parts{};
+    parts.reserve(num_groups + 1);
+    for (size_t i{}; i <= num_groups; ++i) {
+        addPart(parts, &counting);
+    }
+    std::vector<Edges> edges(num_groups);
+    std::vector<uint8_t> good(num_groups);
+    {
+        std::vector<std::jthread> workers{};
+        for (size_t i{}; i < num_groups; ++i) {
+            workers.emplace_back([&group = groups[i], &part = parts[i], &group_edges = edges[i], &group_good = good[i],
+                    format, &parse_part] {
+                DecompressBuf decompressed{group, format};
+                std::istream src{&decompressed};
+                group_edges = forEachStreamLine(src, true, [&](std::string_view const line) {
+                    parse_part(line, part);
+                });
+                group_good = decompressed.Good();
+            });
+        }
+    }
+    // Склейка строк на границах групп: остаток группы и начало следующей
+    Part &stitched{parts.back()};
+    std::string carry{};
+    for (size_t i{}; i < num_groups; ++i) {
+        stats.bytes += edges[i].bytes;
+        read_error = read_error || good[i] == 0;
+        if (edges[i].has_newline) {
+            carry += edges[i].head;
+            parse_part(carry, stitched);
+            carry = std::move(edges[i].tail);
+        } else {
+            carry += edges[i].tail;
+        }
+    }
+    if (!carry.empty()) {
+        parse_part(carry, stitched);
+    }
+    mergeParts(parts);
+}
+
+template<class Func>
+IpFilter::Edges IpFilter::forEachStreamLine(std::istream &src, bool const keep_edges, Func &&func) {
+    Edges edges{};
+    std::vector<char> buffer(kPipelineBlockSize);
+    size_t size{};
+    for (bool more{true}; more;) {
+        if (size == buffer.size()) {
+            // Строка длиннее буфера
+            buffer.resize(buffer.size() * 2);
+        }
+        src.read(buffer.data() + size, static_cast<std::streamsize>(buffer.size() - size));
+        size += static_cast<size_t>(src.gcount());
+        edges.bytes += static_cast<uint64_t>(src.gcount());
+        more = src.good();
+
+        std::string_view text{buffer.data(), size};
+        size_t const last_eol{text.rfind('\n')};
+        if (last_eol == std::string_view::npos) {
+            continue;
+        }
+        std::string_view lines{text.substr(0, last_eol + 1)};
+        if (keep_edges && !edges.has_newline) {
+            size_t const first_eol{lines.find('\n')};
+            edges.head.assign(lines.substr(0, first_eol));
+            lines.remove_prefix(first_eol + 1);
         }
-        Sorting(std::greater{});
-        filter(Otus::task_1, Otus::task_2, Otus::task_3, Otus::task_4);
-        ret = true;
+        edges.has_newline = true;
+        MappedFile::ForEachLine(lines, func);
+        std::memmove(buffer.data(), buffer.data() + last_eol + 1, size - last_eol - 1);
+        size -= last_eol + 1;
     }
-    return ret;
+    if (keep_edges) {
+        edges.tail.assign(buffer.data(), size);
+    } else if (size != 0) {
+        func(std::string_view{buffer.data(), size});
+    }
+    return edges;
 }
 
-void IpFilter::parsing_cxx23(std::string const &line) {
-    for (auto const &ip: std::views::split(line, '\t') |
-                         std::views::take(1) |
-                         std::views::filter(is_valid_size) |
-                         std::views::filter(is_valid_num_points) | // for windows
-                         std::views::transform(convert_to_ip) |
-                         std::views::filter(is_valid_ip) |
-                         std::views::transform(get_ip)) {
-        ips_cxx23.emplace_back(ip);
+bool IpFilter::parsingCxx23() {
+    PhaseClock clock{};
+    ips.clear();
+    readLines(parsing_cxx23);
+    clock.Mark(stats.phases.parse);
+    if (denseToBitmap()) {
+        return true;
     }
+    sorted_descending = false;
+    Sorting(std::greater{});
+    bool const saved{saveIndex()};
+    if (unique) {
+        ips.erase(std::ranges::unique(ips).begin(), ips.end());
+    }
+    clock.Mark(stats.phases.sort);
+    filterCxx23();
+    clock.Mark(stats.phases.filter);
+    return saved;
 }
 
-void IpFilter::ParsingInputVector(std::vector<std::string> const &in) {
-    for (auto const &line: in) {
-        parsing_cxx23(line);
+void IpFilter::filterCxx23() {
+    counted(Section::kTask1, [this] { filter(Otus::task_1); });
+    counted(Section::kTask2, [this] { filter(Otus::task_2); });
+    counted(Section::kTask3, [this] { filter(Otus::task_3); });
+    counted(Section::kTask4, [this] { filter(Otus::task_4); });
+    if (cidr) {
+        counted(Section::kCidr, [this] { filter(*cidr); });
+    }
+    if (rules) {
+        filter_rules([this](auto const &out) {
+            for (uint32_t const ip: addresses()) {
+                out(ip, 1);
+            }
+        });
+    }
+    printAggregation();
+    dst.Flush();
+}
+
+IpParser::Status IpFilter::parsing_cxx23(std::string_view const line, std::pmr::vector<uint32_t> &ips) {
+    // Пустая строка не дает ни одного поля, ее результат - как у пустого поля
+    auto status{std::get<IpParser::Status>(convert_to_ip(std::string_view{}))};
+    for (auto const &ip_info: std::views::split(line, '\t') |
+                              std::views::take(1) |
+                              std::views::transform(convert_to_ip)) {
+        status = std::get<IpParser::Status>(ip_info);
+        if (is_valid_ip(ip_info)) {
+            ips.push_back(get_ip(ip_info).to_uint());
+        }
     }
+    return status;
 }
 
-void IpFilter::Sorting(
-    std::function<bool(boost::asio::ip::address_v4 const &, boost::asio::ip::address_v4 const &)> func) {
-    std::ranges::sort(ips_cxx23, func);
+void IpFilter::ParsingInputVector(std::vector<std::string> const &in) {
+    for (auto const &line: in) {
+        parsing_cxx23(line, ips);
+    }
+    sorted_descending = false;
+    indexed = false;
 }
 
 void IpFilter::filter_task_1() {
-    for (auto const &[str,_]: ips_cxx17) {
-        print(str);
+    for (uint32_t const ip: addresses()) {
+        print(ip);
     }
 }
 
 void IpFilter::filter_task_2() {
-    static constexpr int kFirstByte{3};
+    for (uint32_t const ip: Otus::task_2.Prefix().EqualRange(addresses(), std::identity{})) {
+        print(ip);
+    }
+}
+
+void IpFilter::filter_task_3() {
+    for (uint32_t const ip: Otus::task_3.Prefix().EqualRange(addresses(), std::identity{})) {
+        print(ip);
+    }
+}
 
-    for (auto const &[str,addr]: ips_cxx17) {
-        uint8_t const *raw{reinterpret_cast<uint8_t const *>(&addr)};
-        if (raw[kFirstByte] == 1) {
-            print(str);
+void IpFilter::filter_task_4() {
+    filter_blocks([](auto const keys, auto const matched) {
+        for (size_t i{}; i < keys.size(); ++i) {
+            matched[i] = Otus::task_4(keys[i]);
         }
+    });
+}
+
+void IpFilter::filter_task_cidr() {
+    filter_blocks([this](auto const keys, auto const matched) {
+        cidr->LookupBatch(keys, matched);
+    });
+}
+
+bool IpFilter::parsingCxx17() {
+    PhaseClock clock{};
+    ips.clear();
+    readLines(parsing_cxx17);
+    clock.Mark(stats.phases.parse);
+    if (denseToBitmap()) {
+        return true;
+    }
+    RadixSort::Descending(ips, std::identity{}, threads);
+    sorted_descending = true;
+    bool const saved{saveIndex()};
+    if (unique) {
+        ips.erase(std::ranges::unique(ips).begin(), ips.end());
     }
+    clock.Mark(stats.phases.sort);
+    filterSorted();
+    clock.Mark(stats.phases.filter);
+    return saved;
 }
 
-void IpFilter::filter_task_3() {
-    static constexpr int kFirstByte{3};
-    static constexpr int kSecondByte{2};
+void IpFilter::filterSorted() {
+    counted(Section::kTask1, [this] { filter_task_1(); });
+    counted(Section::kTask2, [this] { filter_task_2(); });
+    counted(Section::kTask3, [this] { filter_task_3(); });
+    counted(Section::kTask4, [this] { filter_task_4(); });
+    if (cidr) {
+        counted(Section::kCidr, [this] { filter_task_cidr(); });
+    }
+    if (rules) {
+        filter_rules([this](auto const &out) {
+            for (uint32_t const ip: addresses()) {
+                out(ip, 1);
+            }
+        });
+    }
+    printAggregation();
+    dst.Flush();
+}
 
-    for (auto const &[str,addr]: ips_cxx17) {
-        uint8_t const *raw{reinterpret_cast<uint8_t const *>(&addr)};
-        if (raw[kFirstByte] == 46 && raw[kSecondByte] == 70) {
-            print(str);
+bool IpFilter::parsingExternal() {
+    PhaseClock clock{};
+    ExternalSort sorter{max_memory};
+    forEachLine([this, &sorter](std::string_view const line) {
+        uint32_t ip{};
+        auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+        countLine(stats, status);
+        if (status == IpParser::Status::kOk) {
+            sorter.Push(ip);
         }
+        if (aggregator) {
+            aggregator->AddLine(line, status, ip);
+        }
+    });
+    clock.Mark(stats.phases.parse);
+    sorter.Finish();
+    clock.Mark(stats.phases.sort);
+
+    // Вывод task_1 идет сразу, остальные фильтры выводятся после него, поэтому откладываются во временные файлы
+    SpillFile task_2{};
+    SpillFile task_3{};
+    SpillFile task_4{};
+    SpillFile task_cidr{};
+    // Потоки правил не зависят от основного вывода, поэтому правила проверяются в том же проходе слияния
+    counted(Section::kTask1, [this, &sorter, &task_2, &task_3, &task_4, &task_cidr] {
+        filter_rules([this, &sorter, &task_2, &task_3, &task_4, &task_cidr](auto const &out) {
+            bool first{true};
+            for (uint32_t ip{}, prev{}; sorter.Next(ip); prev = ip, first = false) {
+                if (unique && !first && ip == prev) {
+                    continue;
+                }
+                print(ip);
+                if (Otus::task_2(ip)) {
+                    task_2.Write(ip);
+                }
+                if (Otus::task_3(ip)) {
+                    task_3.Write(ip);
+                }
+                if (Otus::task_4(ip)) {
+                    task_4.Write(ip);
+                }
+                if (cidr && (*cidr)(ip)) {
+                    task_cidr.Write(ip);
+                }
+                out(ip, 1);
+            }
+        });
+    });
+    for (auto const &[spill, section]: {std::pair{&task_2, Section::kTask2}, std::pair{&task_3, Section::kTask3},
+                                       std::pair{&task_4, Section::kTask4}, std::pair{&task_cidr, Section::kCidr}}) {
+        counted(section, [this, spill] { spill->ForEach([this](uint32_t const ip) { print(ip); }); });
     }
+    printAggregation();
+    dst.Flush();
+    clock.Mark(stats.phases.filter);
+    return sorter.Good() && task_2.Good() && task_3.Good() && task_4.Good() && task_cidr.Good();
 }
 
-void IpFilter::filter_task_4() {
-    for (auto const &[str,addr]: ips_cxx17) {
-        uint8_t const *raw{reinterpret_cast<uint8_t const *>(&addr)};
-        if (std::find(raw, raw + 4, 46) != (raw + 4)) {
-            print(str);
+bool IpFilter::parsingBitmap() {
+    PhaseClock clock{};
+    IpBitmap bitmap{!unique};
+    forEachLine([this, &bitmap](std::string_view const line) {
+        uint32_t ip{};
+        auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+        countLine(stats, status);
+        if (status == IpParser::Status::kOk) {
+            bitmap.Insert(ip);
+        }
+        if (aggregator) {
+            aggregator->AddLine(line, status, ip);
         }
+    });
+    clock.Mark(stats.phases.parse);
+    filterBitmap(bitmap);
+    clock.Mark(stats.phases.filter);
+    return true;
+}
+
+void IpFilter::filterBitmap(IpBitmap const &bitmap) {
+    counted(Section::kTask1, [this, &bitmap] { filter_bitmap(bitmap, Otus::task_1); });
+    counted(Section::kTask2, [this, &bitmap] { filter_bitmap(bitmap, Otus::task_2); });
+    counted(Section::kTask3, [this, &bitmap] { filter_bitmap(bitmap, Otus::task_3); });
+    counted(Section::kTask4, [this, &bitmap] { filter_bitmap(bitmap, Otus::task_4); });
+    if (cidr) {
+        counted(Section::kCidr, [this, &bitmap] { filter_bitmap(bitmap, *cidr); });
+    }
+    if (rules) {
+        filter_rules([&bitmap](auto const &out) {
+            bitmap.ForEachDescending(out);
+        });
     }
+    printAggregation();
+    dst.Flush();
 }
 
-bool IpFilter::parsingCxx17() {
-    bool ret{};
-    if (std::ifstream src{file}; !src.fail()) {
-        std::string line{};
-        while (std::getline(src, line)) {
-            parsing_cxx17(line);
+bool IpFilter::parsingLimit() {
+    PhaseClock clock{};
+    TopK task_1{limit, unique, &counting};
+    TopK task_2{limit, unique, &counting};
+    TopK task_3{limit, unique, &counting};
+    TopK task_4{limit, unique, &counting};
+    TopK task_cidr{limit, unique, &counting};
+    std::vector<TopK> task_rules{};
+    std::vector<uint64_t> mask(rules ? rules->Words() : 0);
+    for (size_t i{}; i < rule_dst.size(); ++i) {
+        task_rules.emplace_back(limit, unique, &counting);
+    }
+    forEachLine([&](std::string_view const line) {
+        uint32_t ip{};
+        auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+        countLine(stats, status);
+        if (status == IpParser::Status::kOk) {
+            task_1.Push(ip);
+            if (Otus::task_2(ip)) {
+                task_2.Push(ip);
+            }
+            if (Otus::task_3(ip)) {
+                task_3.Push(ip);
+            }
+            if (Otus::task_4(ip)) {
+                task_4.Push(ip);
+            }
+            if (cidr && (*cidr)(ip)) {
+                task_cidr.Push(ip);
+            }
+            if (!mask.empty()) {
+                forEachRule(ip, mask, [&task_rules, ip](size_t const rule) { task_rules[rule].Push(ip); });
+            }
         }
-        std::sort(ips_cxx17.begin(), ips_cxx17.end(), [](auto &lhs, auto &rhs) {
-            auto [_1,addr1]{lhs};
-            auto [_2,addr2]{rhs};
-            return addr2 < addr1;
+        if (aggregator) {
+            aggregator->AddLine(line, status, ip);
+        }
+    });
+    clock.Mark(stats.phases.parse);
+    for (auto const &[top, section]: {std::pair{&task_1, Section::kTask1}, std::pair{&task_2, Section::kTask2},
+                                     std::pair{&task_3, Section::kTask3}, std::pair{&task_4, Section::kTask4},
+                                     std::pair{&task_cidr, Section::kCidr}}) {
+        counted(section, [this, top] {
+            for (uint32_t const ip: top->Descending()) {
+                print(ip);
+            }
         });
-        filter_task_1();
-        filter_task_2();
-        filter_task_3();
-        filter_task_4();
-        ret = true;
-    } else {
-        std::string line{};
-        while (std::getline(std::cin, line)) {
-            parsing_cxx17(line);
+    }
+    stats.matches.rules.resize(rule_dst.size());
+    for (size_t i{}; i < rule_dst.size(); ++i) {
+        auto const top{task_rules[i].Descending()};
+        for (uint32_t const ip: top) {
+            rule_dst[i]->Write(ip);
+        }
+        rule_dst[i]->Flush();
+        stats.matches.rules[i] = top.size();
+    }
+    printAggregation();
+    dst.Flush();
+    clock.Mark(stats.phases.filter);
+    return true;
+}
+
+bool IpFilter::denseToBitmap() {
+    // Снимок индекса записывается из отсортированного контейнера
+    if (storage != Storage::kAuto || !unique || !save_index.empty() || IpBitmap::Density(ips) < kBitmapMinDensity) {
+        return false;
+    }
+    PhaseClock clock{};
+    IpBitmap bitmap{};
+    for (uint32_t const ip: ips) {
+        bitmap.Insert(ip);
+    }
+    ips.clear();
+    ips.shrink_to_fit();
+    clock.Mark(stats.phases.sort);
+    filterBitmap(bitmap);
+    clock.Mark(stats.phases.filter);
+    return true;
+}
+
+bool IpFilter::loadIndex() {
+    std::string const &index_file{load_index.empty() ? save_index : load_index};
+    if (index_file.empty() || aggregator || (standard != kCxx17 && standard != kCxx23)) {
+        return false;
+    }
+    // Снимок SetSaveIndex() используется повторно, только если есть исходный файл: данные std::cin
+    // каждый раз разбираются заново, и снимок перезаписывается
+    auto const source{IpIndex::Source::Of(file)};
+    if (load_index.empty() && !source) {
+        return false;
+    }
+    PhaseClock clock{};
+    if (!index.Load(index_file)) {
+        return false;
+    }
+    // Снимок устарел, если исходный файл изменился. Снимок SetLoadIndex() без входного файла используется как есть
+    if (source && *source != index.GetSource()) {
+        index.Close();
+        return false;
+    }
+    clock.Mark(stats.phases.parse);
+    indexed = true;
+    return true;
+}
+
+bool IpFilter::parsingIndex() {
+    PhaseClock clock{};
+    if (unique) {
+        auto const loaded{index.Addresses()};
+        ips.clear();
+        ips.reserve(loaded.size());
+        std::ranges::unique_copy(loaded, std::back_inserter(ips));
+        indexed = false;
+    }
+    sorted_descending = true;
+    clock.Mark(stats.phases.sort);
+    counted(Section::kTask1, [this] { filter(Otus::task_1); });
+    counted(Section::kTask2, [this] { filter(Otus::task_2); });
+    counted(Section::kTask3, [this] { filter(Otus::task_3); });
+    counted(Section::kTask4, [this] { filter(Otus::task_4); });
+    if (cidr) {
+        counted(Section::kCidr, [this] { filter(*cidr); });
+    }
+    if (rules) {
+        filter_rules([this](auto const &out) {
+            for (uint32_t const ip: addresses()) {
+                out(ip, 1);
+            }
+        });
+    }
+    dst.Flush();
+    clock.Mark(stats.phases.filter);
+    return true;
+}
+
+bool IpFilter::saveIndex() {
+    if (save_index.empty()) {
+        return true;
+    }
+    if (!IpIndex::Save(save_index, ips, IpIndex::Source::Of(file).value_or(IpIndex::Source{}))) {
+        std::cout << "Error writing index " << save_index << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void IpFilter::SetSaveIndex(std::string index_file) {
+    save_index = std::move(index_file);
+}
+
+void IpFilter::SetLoadIndex(std::string index_file) {
+    load_index = std::move(index_file);
+}
+
+void IpFilter::SetStorage(Storage const storage_kind) {
+    storage = storage_kind;
+}
+
+void IpFilter::SetUnique(bool const unique_only) {
+    unique = unique_only;
+}
+
+void IpFilter::SetLimit(size_t const top_n) {
+    limit = top_n;
+}
+
+bool IpFilter::written() const {
+    return dst.Good() && std::ranges::all_of(rule_dst, [](auto const &rule_writer) { return rule_writer->Good(); });
+}
+
+void IpFilter::printAggregation() {
+    if (!aggregator) {
+        return;
+    }
+    for (auto const &entry: aggregator->Top(aggregation_top)) {
+        dst.Write(IpAggregator::Format(entry));
+    }
+}
+
+bool IpFilter::Follow(std::istream &src, std::chrono::milliseconds const interval) {
+    stats = {};
+    uint64_t const allocations{counting.Allocations()};
+    PhaseClock clock{};
+    IpRuns runs{IpRuns::kDefaultBufferSize, &counting};
+    std::jthread timer{};
+    if (interval.count() > 0) {
+        timer = std::jthread{[this, interval](std::stop_token const token) {
+            std::mutex mutex{};
+            std::condition_variable_any wake{};
+            std::unique_lock lock{mutex};
+            while (!wake.wait_for(lock, token, interval, [&token] { return token.stop_requested(); })) {
+                RequestEmit();
+            }
+        }};
+    }
+    for (std::string line{}; std::getline(src, line);) {
+        followLine(line, runs);
+        if (emit_requested.exchange(false, std::memory_order_relaxed)) {
+            clock.Mark(stats.phases.parse);
+            emitRuns(runs);
+            clock.Mark(stats.phases.filter);
+        }
+    }
+    clock.Mark(stats.phases.parse);
+    emitRuns(runs);
+    clock.Mark(stats.phases.filter);
+    finishStats(clock, allocations);
+    return !src.bad() && written();
+}
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+bool IpFilter::Follow(int const fd, std::chrono::milliseconds const interval) {
+    using steady_t = std::chrono::steady_clock;
+
+    std::array<int, 2> wake{};
+    if (pipe2(wake.data(), O_NONBLOCK | O_CLOEXEC) != 0) {
+        return false;
+    }
+    stats = {};
+    uint64_t const allocations{counting.Allocations()};
+    PhaseClock clock{};
+    IpRuns runs{IpRuns::kDefaultBufferSize, &counting};
+    wake_fd.store(wake[1], std::memory_order_relaxed);
+
+    std::vector<char> buffer(kFollowReadSize);
+    // Неполная последняя строка прочитанного блока
+    std::string carry{};
+    auto deadline{steady_t::now() + interval};
+    bool error{};
+    for (bool eof{}; !eof && !error;) {
+        // Ожидание ввода или запроса до следующего периодического вывода
+        int timeout{-1};
+        if (interval.count() > 0) {
+            auto const left{std::chrono::ceil<std::chrono::milliseconds>(deadline - steady_t::now())};
+            timeout = static_cast<int>(std::max(left.count(), std::chrono::milliseconds::rep{}));
+        }
+        std::array<pollfd, 2> fds{{{fd, POLLIN, 0}, {wake[0], POLLIN, 0}}};
+        if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) {
+            error = true;
+            break;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            while (read(wake[0], buffer.data(), buffer.size()) > 0) {
+            }
+        }
+        if ((fds[0].revents & POLLNVAL) != 0) {
+            error = true;
+        } else if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+            ssize_t const size{read(fd, buffer.data(), buffer.size())};
+            if (size == 0) {
+                eof = true;
+            } else if (size < 0) {
+                error = errno != EINTR && errno != EAGAIN;
+            } else {
+                std::string_view text{buffer.data(), static_cast<size_t>(size)};
+                for (auto eol{text.find('\n')}; eol != std::string_view::npos; eol = text.find('\n')) {
+                    if (carry.empty()) {
+                        followLine(text.substr(0, eol), runs);
+                    } else {
+                        carry += text.substr(0, eol);
+                        followLine(carry, runs);
+                        carry.clear();
+                    }
+                    text.remove_prefix(eol + 1);
+                }
+                carry += text;
+            }
+        }
+        if (interval.count() > 0 && deadline <= steady_t::now()) {
+            deadline = steady_t::now() + interval;
+            emit_requested.store(true, std::memory_order_relaxed);
         }
-        std::sort(ips_cxx17.begin(), ips_cxx17.end(), [](auto &lhs, auto &rhs) {
-            auto [_1,addr1]{lhs};
-            auto [_2,addr2]{rhs};
-            return addr2 < addr1;
+        if (!eof && emit_requested.exchange(false, std::memory_order_relaxed)) {
+            clock.Mark(stats.phases.parse);
+            emitRuns(runs);
+            clock.Mark(stats.phases.filter);
+        }
+    }
+    wake_fd.store(-1, std::memory_order_relaxed);
+    close(wake[0]);
+    close(wake[1]);
+
+    if (!carry.empty()) {
+        followLine(carry, runs);
+    }
+    clock.Mark(stats.phases.parse);
+    emitRuns(runs);
+    clock.Mark(stats.phases.filter);
+    finishStats(clock, allocations);
+    return !error && written();
+}
+#endif
+
+void IpFilter::followLine(std::string_view const line, IpRuns &runs) {
+    stats.bytes += line.size() + 1;
+    uint32_t ip{};
+    auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+    countLine(stats, status);
+    if (status == IpParser::Status::kOk) {
+        runs.Insert(ip);
+    }
+    if (aggregator) {
+        aggregator->AddLine(line, status, ip);
+    }
+}
+
+void IpFilter::emitRuns(IpRuns &runs) {
+    runs.Seal();
+    counted(Section::kTask1, [this, &runs] { filter_runs(runs, Otus::task_1); });
+    counted(Section::kTask2, [this, &runs] { filter_runs(runs, Otus::task_2); });
+    counted(Section::kTask3, [this, &runs] { filter_runs(runs, Otus::task_3); });
+    counted(Section::kTask4, [this, &runs] { filter_runs(runs, Otus::task_4); });
+    if (cidr) {
+        counted(Section::kCidr, [this, &runs] { filter_runs(runs, *cidr); });
+    }
+    if (rules) {
+        filter_rules([this, &runs](auto const &out) {
+            bool first{true};
+            uint32_t prev{};
+            runs.ForEachDescending([this, &out, &first, &prev](uint32_t const ip) {
+                if (!unique || first || ip != prev) {
+                    out(ip, 1);
+                }
+                first = false;
+                prev = ip;
+            });
         });
-        filter_task_1();
-        filter_task_2();
-        filter_task_3();
-        filter_task_4();
-        ret = true;
     }
-    return ret;
+    printAggregation();
+    dst.Flush();
+    // Промежуточные результаты видны сразу, даже если std::cout перенаправлен в файл
+    if (!dst.IsFile()) {
+        std::cout.flush();
+    }
+}
+
+void IpFilter::RequestEmit() {
+    emit_requested.store(true, std::memory_order_relaxed);
+#ifndef WINDOWS_SPECIFIC_FLAG
+    // write() допустим в обработчике сигнала; полный канал уже будит ожидание
+    if (int const fd{wake_fd.load(std::memory_order_relaxed)}; fd != -1) {
+        static constexpr char kWake{};
+        static_cast<void>(write(fd, &kWake, sizeof(kWake)));
+    }
+#endif
+}
+
+void IpFilter::SetAggregation(int const prefix_length, size_t const top_n) {
+    aggregator.emplace(prefix_length);
+    aggregation_top = top_n;
+}
+
+void IpFilter::SetStats(bool const enabled) {
+    collect_stats = enabled;
+}
+
+IpStats const &IpFilter::Stats() const {
+    return stats;
+}
+
+void IpFilter::SetMaxMemory(size_t const bytes) {
+    max_memory = bytes;
+}
+
+void IpFilter::SetThreads(unsigned const num_threads) {
+    threads = std::clamp(num_threads, 1u, kMaxThreads);
+}
+
+unsigned IpFilter::Threads() const {
+    return threads;
+}
+
+bool IpFilter::LoadCidrFile(std::string const &cidr_file) {
+    if (CidrSet cidr_set{}; cidr_set.Load(cidr_file)) {
+        cidr.emplace(std::move(cidr_set));
+        return true;
+    }
+    return false;
 }
 
-std::vector<boost::asio::ip::address_v4> IpFilter::GetIPs() const {
-    return ips_cxx23;
+bool IpFilter::LoadRulesFile(std::string const &rules_file) {
+    RuleSet rule_set{};
+    if (!rule_set.Load(rules_file)) {
+        return false;
+    }
+    // Потоки правил держат небольшой буфер и открывают файл только на время сброса
+    std::vector<std::unique_ptr<IpWriter> > writers{};
+    writers.reserve(rule_set.Rules().size());
+    for (auto const &rule: rule_set.Rules()) {
+        writers.push_back(std::make_unique<IpWriter>(rule.output, kRuleBufferSize, IpWriter::Open::kOnFlush));
+        if (!writers.back()->Good()) {
+            return false;
+        }
+    }
+    rule_dst = std::move(writers);
+    rules.emplace(std::move(rule_set));
+    return true;
 }
+
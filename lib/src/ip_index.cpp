@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include "ip_index.h"
+
+std::optional<IpIndex::Source> IpIndex::Source::Of(std::string const &file) {
+    std::error_code error{};
+    auto const size{std::filesystem::file_size(file, error)};
+    if (error) {
+        return {};
+    }
+    auto const mtime{std::filesystem::last_write_time(file, error)};
+    if (error) {
+        return {};
+    }
+    return Source{size, static_cast<int64_t>(mtime.time_since_epoch().count())};
+}
+
+uint64_t IpIndex::checksum(std::span<uint64_t const> const offsets, std::span<uint32_t const> const sorted) {
+    static constexpr uint64_t kOffsetBasis{14695981039346656037ull};
+    static constexpr uint64_t kPrime{1099511628211ull};
+
+    uint64_t hash{kOffsetBasis};
+    for (uint64_t const offset: offsets) {
+        hash = (hash ^ offset) * kPrime;
+    }
+    for (uint32_t const ip: sorted) {
+        hash = (hash ^ ip) * kPrime;
+    }
+    return hash;
+}
+
+bool IpIndex::Save(std::string const &file, std::span<uint32_t const> const sorted, Source const &source) {
+    Header header{kMagic, kVersion, sorted.size(), source.size, source.mtime};
+    // offsets[i] - количество адресов с первым октетом не меньше kNumOctets - i
+    for (size_t i{}; i <= kNumOctets; ++i) {
+        uint32_t const octet{static_cast<uint32_t>(kNumOctets - i)};
+        auto const border{std::ranges::partition_point(sorted, [octet](uint32_t const ip) {
+            return octet <= ip >> kFirstOctetShift;
+        })};
+        header.offsets[i] = static_cast<uint64_t>(border - sorted.begin());
+    }
+    header.checksum = checksum(header.offsets, sorted);
+
+    auto const closer{[](std::FILE *const stream) { std::fclose(stream); }};
+    std::string const tmp{file + ".tmp"};
+    bool written{};
+    if (std::unique_ptr<std::FILE, decltype(closer)> stream{std::fopen(tmp.c_str(), "wb"), closer}; stream) {
+        written = std::fwrite(&header, sizeof(header), 1, stream.get()) == 1 &&
+                  std::fwrite(sorted.data(), sizeof(uint32_t), sorted.size(), stream.get()) == sorted.size() &&
+                  std::fflush(stream.get()) == 0;
+    }
+    std::error_code error{};
+    if (written) {
+        std::filesystem::rename(tmp, file, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(tmp, error);
+        return false;
+    }
+    return true;
+}
+
+bool IpIndex::Load(std::string const &file) {
+    Close();
+    mapped.emplace(file);
+    std::string_view const view{mapped->View()};
+    bool valid{mapped->IsOpen() && sizeof(Header) <= view.size()};
+    if (valid) {
+        std::memcpy(&header, view.data(), sizeof(Header));
+        valid = header.magic == kMagic && header.version == kVersion &&
+                (view.size() - sizeof(Header)) % sizeof(uint32_t) == 0 &&
+                (view.size() - sizeof(Header)) / sizeof(uint32_t) == header.count &&
+                header.offsets.front() == 0 && header.offsets.back() == header.count &&
+                std::ranges::is_sorted(header.offsets);
+    }
+    if (valid) {
+        // Отображение выровнено по странице, а размер заголовка кратен 8, поэтому адреса выровнены
+        static_assert(sizeof(Header) % alignof(uint64_t) == 0);
+        addresses = {reinterpret_cast<uint32_t const *>(view.data() + sizeof(Header)), header.count};
+        valid = checksum(header.offsets, addresses) == header.checksum;
+    }
+    if (!valid) {
+        Close();
+    }
+    return valid;
+}
+
+void IpIndex::Close() {
+    addresses = {};
+    mapped.reset();
+}
+
+bool IpIndex::IsOpen() const {
+    return mapped.has_value();
+}
+
+IpIndex::Source IpIndex::GetSource() const {
+    return {header.source_size, header.source_mtime};
+}
+
+std::span<uint32_t const> IpIndex::Addresses() const {
+    return addresses;
+}
+
+std::span<uint32_t const> IpIndex::FirstOctet(uint8_t const octet) const {
+    if (!IsOpen()) {
+        return {};
+    }
+    size_t const beg{header.offsets[kNumOctets - 1 - octet]};
+    size_t const end{header.offsets[kNumOctets - octet]};
+    return addresses.subspan(beg, end - beg);
+}
+
+std::span<uint32_t const> IpIndex::EqualRange(IpPrefix const &prefix) const {
+    if (!IsOpen()) {
+        return {};
+    }
+    auto const first_octet{static_cast<uint8_t>(prefix.First() >> kFirstOctetShift)};
+    auto const last_octet{static_cast<uint8_t>(prefix.Last() >> kFirstOctetShift)};
+    size_t const beg{header.offsets[kNumOctets - 1 - last_octet]};
+    size_t const end{header.offsets[kNumOctets - first_octet]};
+    return prefix.EqualRange(addresses.subspan(beg, end - beg), std::identity{});
+}
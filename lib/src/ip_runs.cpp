@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <functional>
+#include "ip_runs.h"
+#include "radix_sort.h"
+
+IpRuns::IpRuns(size_t const buffer_size, std::pmr::memory_resource *const resource) :
+    buffer_size{std::max(buffer_size, size_t{1})}, resource{resource}, buffer{resource} {
+    buffer.reserve(this->buffer_size);
+}
+
+void IpRuns::Seal() {
+    if (buffer.empty()) {
+        return;
+    }
+    RadixSort::Descending(buffer, std::identity{});
+    runs.emplace_back(std::move(buffer));
+    buffer = std::pmr::vector<uint32_t>{resource};
+    buffer.reserve(buffer_size);
+    while (runs.size() > 1 && runs[runs.size() - 2].size() <= kMergeRatio * runs.back().size()) {
+        mergeLast();
+    }
+}
+
+void IpRuns::mergeLast() {
+    auto &older{runs[runs.size() - 2]};
+    auto const &newer{runs.back()};
+    std::pmr::vector<uint32_t> merged{resource};
+    merged.reserve(older.size() + newer.size());
+    std::ranges::merge(older, newer, std::back_inserter(merged), std::greater{});
+    older = std::move(merged);
+    runs.pop_back();
+}
+
+size_t IpRuns::Size() const {
+    size_t size{buffer.size()};
+    for (auto const &run: runs) {
+        size += run.size();
+    }
+    return size;
+}
+
+size_t IpRuns::NumRuns() const {
+    return runs.size();
+}
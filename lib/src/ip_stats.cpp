@@ -0,0 +1,91 @@
+#include <numeric>
+#include <string_view>
+#include "ip_stats.h"
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+#include <sys/resource.h>
+#endif
+
+void IpStats::Merge(IpStats const &other) {
+    bytes += other.bytes;
+    lines += other.lines;
+    accepted += other.accepted;
+    for (size_t i{}; i < kNumReasons; ++i) {
+        rejected[i] += other.rejected[i];
+    }
+}
+
+uint64_t IpStats::Rejected() const {
+    return std::accumulate(rejected.begin(), rejected.end(), uint64_t{});
+}
+
+std::string IpStats::ToJson() const {
+    static constexpr std::array<char const *, kNumReasons> kReasons{"too_long", "bad_dots", "bad_char", "bad_octet"};
+
+    std::string json{};
+    // Поле "name":value, перед полем объекта кроме первого ставится запятая
+    auto const field{[&json](std::string_view const name, auto const value) {
+        if (json.back() != '{') {
+            json += ',';
+        }
+        json += '"';
+        json += name;
+        json += "\":";
+        json += std::to_string(value);
+    }};
+    auto const object{[&json](std::string_view const name) {
+        json += ",\"";
+        json += name;
+        json += "\":{";
+    }};
+
+    json += '{';
+    field("bytes", bytes);
+    field("lines", lines);
+    field("accepted", accepted);
+    object("rejected");
+    for (size_t i{}; i < kNumReasons; ++i) {
+        field(kReasons[i], rejected[i]);
+    }
+    json += '}';
+    object("matches");
+    field("task_1", matches.task_1);
+    field("task_2", matches.task_2);
+    field("task_3", matches.task_3);
+    field("task_4", matches.task_4);
+    field("cidr", matches.cidr);
+    if (!matches.rules.empty()) {
+        json += ",\"rules\":[";
+        for (size_t i{}; i < matches.rules.size(); ++i) {
+            if (i != 0) {
+                json += ',';
+            }
+            json += std::to_string(matches.rules[i]);
+        }
+        json += ']';
+    }
+    json += '}';
+    object("memory");
+    field("allocations", allocations);
+    field("peak_bytes", peak_bytes);
+    field("max_rss_kb", max_rss_kb);
+    json += '}';
+    object("phases_ns");
+    field("read", phases.read.count());
+    field("parse", phases.parse.count());
+    field("sort", phases.sort.count());
+    field("filter", phases.filter.count());
+    field("write", phases.write.count());
+    field("total", phases.total.count());
+    json += "}}";
+    return json;
+}
+
+uint64_t MaxRssKb() {
+#ifndef WINDOWS_SPECIFIC_FLAG
+    if (rusage usage{}; ::getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<uint64_t>(usage.ru_maxrss);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <iostream>
+#include "ip_writer.h"
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+IpWriter::IpWriter(std::string const &file, size_t const buffer_size, Open const open) : path{file}, open{open},
+    buffer_size{std::max(buffer_size, kMaxLineSize)} {
+    if (path.empty()) {
+        return;
+    }
+#ifdef WINDOWS_SPECIFIC_FLAG
+    dst.open(path, std::ios::binary);
+    failed = !dst.is_open();
+    if (open == Open::kOnFlush) {
+        dst.close();
+    }
+#else
+    static constexpr int kMode{0644};
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, kMode);
+    failed = fd < 0;
+    if (open == Open::kOnFlush && fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+IpWriter::~IpWriter() {
+    Flush();
+#ifndef WINDOWS_SPECIFIC_FLAG
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+}
+
+void IpWriter::Write(std::string_view const line) {
+    if (buffer.size() - pos <= line.size()) {
+        makeRoom();
+        if (buffer.size() <= line.size()) {
+            writeAll(line.data(), line.size());
+            writeAll("\n", 1);
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + pos, line.data(), line.size());
+    pos += line.size();
+    buffer[pos++] = '\n';
+}
+
+void IpWriter::makeRoom() {
+    Flush();
+    if (buffer.empty()) {
+        buffer.resize(buffer_size);
+    }
+}
+
+void IpWriter::Flush() {
+    if (pos != 0) {
+        writeAll(buffer.data(), pos);
+        pos = 0;
+    }
+}
+
+uint64_t IpWriter::NumIps() const {
+    return num_ips;
+}
+
+std::chrono::nanoseconds IpWriter::WriteTime() const {
+    return write_time;
+}
+
+bool IpWriter::Good() const {
+    return !failed;
+}
+
+bool IpWriter::IsFile() const {
+    return !path.empty();
+}
+
+void IpWriter::writeAll(char const *data, size_t size) {
+    // Время замеряется на сброс буфера (раз в kBufferSize байт), а не на строку
+    struct Timer {
+        std::chrono::nanoseconds &total;
+        std::chrono::steady_clock::time_point const start{std::chrono::steady_clock::now()};
+
+        ~Timer() {
+            total += std::chrono::steady_clock::now() - start;
+        }
+    } const timer{write_time};
+
+    if (failed) {
+        return;
+    }
+    if (path.empty()) {
+        auto const length{static_cast<std::streamsize>(size)};
+        failed = std::cout.rdbuf() == nullptr || std::cout.rdbuf()->sputn(data, length) != length;
+        return;
+    }
+    if (open == Open::kKeep) {
+        writeFile(data, size);
+        return;
+    }
+    // Файл открывается только на время записи, поэтому число открытых файлов не зависит от числа объектов
+#ifdef WINDOWS_SPECIFIC_FLAG
+    dst.open(path, std::ios::binary | std::ios::app);
+    writeFile(data, size);
+    dst.close();
+#else
+    fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    writeFile(data, size);
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+void IpWriter::writeFile(char const *data, size_t size) {
+#ifdef WINDOWS_SPECIFIC_FLAG
+    failed = !dst.is_open() || !dst.write(data, static_cast<std::streamsize>(size));
+#else
+    if (fd < 0) {
+        failed = true;
+        return;
+    }
+    while (size != 0) {
+        ssize_t const written{::write(fd, data, size)};
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed = true;
+            return;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#endif
+}
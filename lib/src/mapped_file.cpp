@@ -0,0 +1,93 @@
+#include <algorithm>
+#include "mapped_file.h"
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string const &file) {
+#ifndef WINDOWS_SPECIFIC_FLAG
+    if (file.empty()) {
+        return;
+    }
+    int const fd{::open(file.c_str(), O_RDONLY)};
+    if (fd < 0) {
+        return;
+    }
+    if (struct stat st{}; ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        size = static_cast<size_t>(st.st_size);
+        if (size == 0) {
+            is_open = true;
+        } else if (void *const addr{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)}; addr != MAP_FAILED) {
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+            ::madvise(addr, size, MADV_WILLNEED);
+            data = static_cast<char const *>(addr);
+            is_open = true;
+        } else {
+            size = 0;
+        }
+    }
+    ::close(fd);
+#else
+    static_cast<void>(file);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef WINDOWS_SPECIFIC_FLAG
+    if (data != nullptr) {
+        ::munmap(const_cast<char *>(data), size);
+    }
+#endif
+}
+
+bool MappedFile::IsOpen() const {
+    return is_open;
+}
+
+std::string_view MappedFile::View() const {
+    return {data, size};
+}
+
+void MappedFile::Prefault() const {
+    static constexpr size_t kPageSize{4096};
+
+    char volatile sink{};
+    for (size_t offset{}; offset < size; offset += kPageSize) {
+        sink = data[offset];
+    }
+    static_cast<void>(sink);
+}
+
+std::vector<std::string_view> MappedFile::SplitLines(std::string_view text, size_t const num_parts) {
+    std::vector<std::string_view> parts{};
+    size_t const part_size{text.size() / std::max<size_t>(num_parts, 1) + 1};
+    while (!text.empty()) {
+        size_t const eol{text.find('\n', std::min(part_size, text.size()) - 1)};
+        size_t const size{eol == std::string_view::npos ? text.size() : eol + 1};
+        parts.push_back(text.substr(0, size));
+        text.remove_prefix(size);
+    }
+    return parts;
+}
+
+size_t MappedFile::EstimateLines(std::string_view const text) {
+    static constexpr size_t kNumSamples{8};
+    static constexpr size_t kSampleSize{1 << 14};
+    static constexpr int kMarginShift{4};
+
+    if (text.size() <= kNumSamples * kSampleSize) {
+        return static_cast<size_t>(std::ranges::count(text, '\n')) + 1;
+    }
+    size_t const step{(text.size() - kSampleSize) / (kNumSamples - 1)};
+    size_t newlines{};
+    for (size_t i{}; i < kNumSamples; ++i) {
+        newlines += static_cast<size_t>(std::ranges::count(text.substr(i * step, kSampleSize), '\n'));
+    }
+    auto const lines{static_cast<size_t>(static_cast<double>(text.size()) * static_cast<double>(newlines) /
+                                         static_cast<double>(kNumSamples * kSampleSize))};
+    return lines + (lines >> kMarginShift) + 1;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <optional>
+#include <utility>
+#include "ip_parser.h"
+#include "ip_prefix.h"
+#include "mapped_file.h"
+#include "rule_set.h"
+
+namespace {
+    /// Диапазон значений октета [first, last]
+    struct OctetRange {
+        uint32_t first{};
+        uint32_t last{};
+    };
+
+    using octet_ranges_t = std::array<OctetRange, 4>;
+
+    /// Разбор числа 0..255 целиком
+    std::optional<uint32_t> parseOctet(std::string_view const str) {
+        static constexpr uint32_t kMaxOctet{255};
+
+        uint32_t value{};
+        auto const [ptr, ec]{std::from_chars(str.data(), str.data() + str.size(), value)};
+        if (str.empty() || ec != std::errc{} || ptr != str.data() + str.size() || kMaxOctet < value) {
+            return {};
+        }
+        return value;
+    }
+
+    /// Разбор октета шаблона: "*", "n" или "n-m"
+    std::optional<OctetRange> parseOctetRange(std::string_view const str) {
+        static constexpr OctetRange kAnyValue{0, 255};
+
+        if (str == "*") {
+            return kAnyValue;
+        }
+        auto const dash{str.find('-')};
+        auto const first{parseOctet(str.substr(0, dash))};
+        if (!first) {
+            return {};
+        }
+        if (dash == std::string_view::npos) {
+            return OctetRange{*first, *first};
+        }
+        auto const last{parseOctet(str.substr(dash + 1))};
+        if (!last || *last < *first) {
+            return {};
+        }
+        return OctetRange{*first, *last};
+    }
+
+    /// Разбор CIDR префикса "a.b.c.d/len" в диапазоны октетов
+    std::optional<octet_ranges_t> parsePrefix(std::string_view const str) {
+        static constexpr int kMaxLen{32};
+        static constexpr uint32_t kOctetMask{0xFF};
+
+        auto const slash{str.find('/')};
+        uint32_t ip{};
+        if (IpParser::Parse(str.substr(0, slash), ip) != IpParser::Status::kOk) {
+            return {};
+        }
+        std::string_view const len_str{str.substr(slash + 1)};
+        int len{};
+        auto const [ptr, ec]{std::from_chars(len_str.data(), len_str.data() + len_str.size(), len)};
+        if (ec != std::errc{} || ptr != len_str.data() + len_str.size() || len < 0 || kMaxLen < len) {
+            return {};
+        }
+        // Префикс непрерывный: октеты до неполного фиксированы, неполный - диапазон, после него - любые
+        IpPrefix const prefix{ip, len};
+        octet_ranges_t ranges{};
+        for (int octet{}, shift{24}; octet < 4; ++octet, shift -= 8) {
+            ranges[octet] = {prefix.First() >> shift & kOctetMask, prefix.Last() >> shift & kOctetMask};
+        }
+        return ranges;
+    }
+
+    /// Разбор шаблона "a.b.c.d" в диапазоны октетов
+    std::optional<octet_ranges_t> parseOctets(std::string_view str) {
+        octet_ranges_t ranges{};
+        for (auto &range: ranges) {
+            auto const dot{str.find('.')};
+            auto const parsed{parseOctetRange(str.substr(0, dot))};
+            if (!parsed || (&range != &ranges.back()) == (dot == std::string_view::npos)) {
+                return {};
+            }
+            range = *parsed;
+            str.remove_prefix(dot == std::string_view::npos ? str.size() : dot + 1);
+        }
+        return ranges;
+    }
+
+    /// Строка без комментария и пробельных символов по краям
+    std::string_view trim(std::string_view str) {
+        static constexpr std::string_view kSpaces{" \t\r"};
+
+        str = str.substr(0, str.find('#'));
+        auto const beg{str.find_first_not_of(kSpaces)};
+        if (beg == std::string_view::npos) {
+            return {};
+        }
+        return str.substr(beg, str.find_last_not_of(kSpaces) - beg + 1);
+    }
+}
+
+bool RuleSet::Load(std::string const &file) {
+    static constexpr std::string_view kSpaces{" \t"};
+
+    size_t num_rejected{};
+    auto const add{
+        [this, &file, &num_rejected](std::string_view const line) {
+            std::string_view const str{trim(line)};
+            if (str.empty()) {
+                return;
+            }
+            auto const end{str.find_first_of(kSpaces)};
+            std::string_view const pattern{str.substr(0, end)};
+            std::string output{};
+            if (end != std::string_view::npos) {
+                output = str.substr(str.find_first_not_of(kSpaces, end));
+            } else {
+                output = file + '.' + std::to_string(rules.size() + 1);
+            }
+            if (!Add(pattern, std::move(output))) {
+                ++num_rejected;
+            }
+        }
+    };
+
+    if (MappedFile const mapped{file}; mapped.IsOpen()) {
+        MappedFile::ForEachLine(mapped.View(), add);
+    } else if (std::ifstream src{file}; !src.fail()) {
+        std::string line{};
+        while (std::getline(src, line)) {
+            add(line);
+        }
+    } else {
+        return false;
+    }
+    rejected += num_rejected;
+    return true;
+}
+
+bool RuleSet::Add(std::string_view const pattern, std::string output) {
+    static constexpr std::string_view kAnyPrefix{"any=="};
+
+    std::optional<uint32_t> any_value{};
+    std::optional<octet_ranges_t> ranges{};
+    if (pattern.starts_with(kAnyPrefix)) {
+        any_value = parseOctet(pattern.substr(kAnyPrefix.size()));
+    } else if (pattern.find('/') != std::string_view::npos) {
+        ranges = parsePrefix(pattern);
+    } else {
+        ranges = parseOctets(pattern);
+    }
+    if (!any_value && !ranges) {
+        return false;
+    }
+
+    reserveBit();
+    size_t const bit{rules.size()};
+    size_t const word{bit / kWordBits};
+    uint64_t const flag{uint64_t{1} << (bit % kWordBits)};
+    if (any_value) {
+        any[*any_value * words + word] |= flag;
+    } else {
+        for (size_t octet{}; octet < kNumOctets; ++octet) {
+            for (uint32_t value{(*ranges)[octet].first}; value <= (*ranges)[octet].last; ++value) {
+                octets[(octet * kNumValues + value) * words + word] |= flag;
+            }
+        }
+    }
+    rules.push_back({std::string{pattern}, std::move(output)});
+    return true;
+}
+
+void RuleSet::reserveBit() {
+    if (rules.size() < words * kWordBits) {
+        return;
+    }
+    // Строки таблиц расширяются на одно слово, маски существующих правил сохраняются
+    auto const widen{[this](std::vector<uint64_t> const &table, size_t const num_rows) {
+        std::vector<uint64_t> wide(num_rows * (words + 1));
+        for (size_t row{}; row < num_rows; ++row) {
+            std::copy_n(table.begin() + static_cast<std::ptrdiff_t>(row * words), words,
+                        wide.begin() + static_cast<std::ptrdiff_t>(row * (words + 1)));
+        }
+        return wide;
+    }};
+    octets = widen(octets, kNumOctets * kNumValues);
+    any = widen(any, kNumValues);
+    ++words;
+}
+
+size_t RuleSet::Size() const {
+    return rules.size();
+}
+
+size_t RuleSet::Words() const {
+    return words;
+}
+
+std::span<RuleSet::Rule const> RuleSet::Rules() const {
+    return rules;
+}
+
+size_t RuleSet::Rejected() const {
+    return rejected;
+}
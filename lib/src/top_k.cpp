@@ -0,0 +1,35 @@
+#include <algorithm>
+#include <functional>
+#include "top_k.h"
+
+TopK::TopK(size_t const k, bool const unique, std::pmr::memory_resource *const resource) : k{k}, unique{unique},
+    capacity{std::max(2 * k, size_t{1})}, buffer{resource}, threshold{k == 0 ? ~uint32_t{} : 0}, full{k == 0} {
+    // При k = 0 порог - наибольший адрес, поэтому любой адрес отбрасывается
+    buffer.reserve(capacity);
+}
+
+void TopK::compact() {
+    if (unique) {
+        // Повторы удаляются перед выбором, поэтому k наибольших различны
+        std::ranges::sort(buffer, std::greater{});
+        buffer.erase(std::ranges::unique(buffer).begin(), buffer.end());
+    }
+    if (buffer.size() < k) {
+        return;
+    }
+    if (!unique) {
+        std::ranges::nth_element(buffer, buffer.begin() + static_cast<std::ptrdiff_t>(k - 1), std::greater{});
+    }
+    buffer.resize(k);
+    // k-й наибольший стоит на месте k - 1 и после сортировки, и после nth_element
+    threshold = buffer[k - 1];
+    full = true;
+}
+
+std::span<uint32_t const> TopK::Descending() {
+    if (k != 0) {
+        compact();
+    }
+    std::ranges::sort(buffer, std::greater{});
+    return buffer;
+}
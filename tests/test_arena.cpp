@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "arena.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_arena, bump) {
+    static constexpr size_t kBlockSize{1 << 10};
+    static constexpr size_t kNumInts{10000};
+
+    CountingResource counting{};
+    {
+        Arena<kBlockSize> arena{&counting};
+        std::pmr::vector<int> ints{&arena};
+        for (size_t i{}; i < kNumInts; ++i) {
+            ints.push_back(static_cast<int>(i));
+        }
+        ASSERT_EQ(std::accumulate(ints.begin(), ints.end(), size_t{}), kNumInts * (kNumInts - 1) / 2);
+
+        // Выравнивание соблюдается после невыровненного выделения
+        static_cast<void>(arena.allocate(1, 1));
+        void *const aligned{arena.allocate(sizeof(double), alignof(double))};
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % alignof(double), 0);
+
+        ASSERT_EQ(counting.Allocations(), arena.NumBlocks());
+        ASSERT_GE(arena.Used(), kNumInts * sizeof(int));
+        ASSERT_GT(counting.InUse(), 0);
+    }
+    // Деструктор арены возвращает все блоки
+    ASSERT_EQ(counting.InUse(), 0);
+    ASSERT_GE(counting.Peak(), kNumInts * sizeof(int));
+}
+
+TEST(test_arena, release) {
+    CountingResource counting{};
+    Arena<> arena{&counting};
+    std::pmr::string str{"string longer than the small string buffer", &arena};
+    ASSERT_EQ(arena.NumBlocks(), 1);
+    arena.Release();
+    ASSERT_EQ(arena.NumBlocks(), 0);
+    ASSERT_EQ(arena.Used(), 0);
+    ASSERT_EQ(counting.InUse(), 0);
+}
+
+TEST(test_arena, huge_pages) {
+    static constexpr size_t kNumInts{HugePageResource::kHugePageSize};
+
+    CountingResource counting{};
+    HugePageResource huge{&counting};
+    {
+        // Небольшой контейнер берется у upstream
+        std::pmr::vector<int> small{{1, 2, 3}, &huge};
+        ASSERT_EQ(counting.Allocations(), 1);
+        ASSERT_EQ(huge.Mapped(), 0);
+
+        std::pmr::vector<int> large(kNumInts, &huge);
+        std::iota(large.begin(), large.end(), 0);
+        ASSERT_EQ(large[kNumInts - 1], static_cast<int>(kNumInts - 1));
+#ifdef __linux__
+        ASSERT_EQ(huge.Mapped(), 1);
+        ASSERT_EQ(counting.Allocations(), 1);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(large.data()) % HugePageResource::kHugePageSize, 0);
+#endif
+        ASSERT_LE(huge.HugeTlb(), huge.Mapped());
+    }
+    ASSERT_EQ(counting.InUse(), 0);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "cidr_set.h"
+
+namespace {
+    /// Поиск наиболее длинного префикса перебором
+    uint8_t lookupBruteForce(std::vector<IpPrefix> const &prefixes, uint32_t const ip) {
+        int len{-1};
+        for (auto const &prefix: prefixes) {
+            if (prefix(ip)) {
+                len = std::max(len, prefix.length);
+            }
+        }
+        return len < 0 ? 0 : static_cast<uint8_t>(std::max(len, 1));
+    }
+}
+
+//--------------------TESTS--------------------
+
+TEST(test_cidr_set, longest_prefix_match) {
+    static constexpr int kNumIps{20000};
+    static std::vector<IpPrefix> const kPrefixes{
+        {0x2E000000, 8}, {0x2E460000, 16}, {0x2E467100, 24}, {0x2E467148, 29}, {0x2E467149, 32},
+        {0x01000000, 8}, {0x01020300, 25}, {0x01020380, 26}, {0xC0A80000, 16},
+    };
+
+    CidrSet const cidr_set{kPrefixes};
+    ASSERT_EQ(cidr_set.Size(), kPrefixes.size());
+
+    std::mt19937 gen{1};
+    std::vector<uint32_t> ips(kNumIps);
+    // Адреса рядом с префиксами, чтобы проверить и совпадения, и промахи
+    std::ranges::generate(ips, [&] {
+        return kPrefixes[gen() % kPrefixes.size()].value ^ (gen() >> (gen() % 32));
+    });
+    std::vector<uint8_t> batch(ips.size());
+    cidr_set.LookupBatch(ips, batch);
+    for (size_t i{}; i < ips.size(); ++i) {
+        ASSERT_EQ(cidr_set.Lookup(ips[i]), lookupBruteForce(kPrefixes, ips[i])) << ips[i];
+        ASSERT_EQ(batch[i], cidr_set.Lookup(ips[i])) << ips[i];
+    }
+}
+
+TEST(test_cidr_set, load) {
+    auto const file{std::filesystem::temp_directory_path() / "test_cidr_set.txt"};
+    {
+        std::ofstream dst{file};
+        dst << "# blocklist\n"
+                "46.70.0.0/16\n"
+                "  1.2.3.4  # host\n"
+                "\n"
+                "10.0.0.0/33\n"
+                "10.0.0/8\n"
+                "256.0.0.0/8\r\n";
+    }
+    CidrSet cidr_set{};
+    ASSERT_TRUE(cidr_set.Load(file.string()));
+    std::filesystem::remove(file);
+
+    ASSERT_EQ(cidr_set.Size(), 2);
+    ASSERT_EQ(cidr_set.Rejected(), 3);
+    ASSERT_EQ(cidr_set.Lookup(0x2E467149), 16);
+    ASSERT_EQ(cidr_set.Lookup(0x01020304), 32);
+    ASSERT_EQ(cidr_set.Lookup(0x01020305), 0);
+    ASSERT_FALSE(cidr_set.Load("not_exists.txt"));
+}
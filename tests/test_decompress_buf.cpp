@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <istream>
+#include <iterator>
+#include <string>
+#include "decompress_buf.h"
+#include "mapped_file.h"
+
+namespace {
+    /// Распаковать данные целиком через std::istream
+    std::string decompress(std::string_view const data, bool &good) {
+        DecompressBuf decompressed{data, DecompressBuf::Detect(data)};
+        std::istream src{&decompressed};
+        std::string text{std::istreambuf_iterator<char>{src}, std::istreambuf_iterator<char>{}};
+        good = decompressed.Good();
+        return text;
+    }
+}
+
+//--------------------TESTS--------------------
+
+TEST(test_decompress_buf, detect) {
+    ASSERT_EQ(DecompressBuf::Detect("\x1F\x8B\x08"), DecompressBuf::Format::kGzip);
+    ASSERT_EQ(DecompressBuf::Detect("\x28\xB5\x2F\xFD"), DecompressBuf::Format::kZstd);
+    ASSERT_EQ(DecompressBuf::Detect("1.2.3.4\t"), DecompressBuf::Format::kPlain);
+    ASSERT_EQ(DecompressBuf::Detect(""), DecompressBuf::Format::kPlain);
+    ASSERT_TRUE(DecompressBuf::Supported(DecompressBuf::Format::kPlain));
+}
+
+TEST(test_decompress_buf, plain) {
+    static std::string const kText{"1.2.3.4\t1\t2\n5.6.7.8\t3\t4\n"};
+
+    bool good{};
+    ASSERT_EQ(decompress(kText, good), kText);
+    ASSERT_TRUE(good);
+}
+
+TEST(test_decompress_buf, compressed) {
+    MappedFile const plain{"ip_filter.tsv"};
+    for (std::string const file: {"ip_filter.tsv.gz", "ip_filter.tsv.zst"}) {
+        MappedFile const mapped{file};
+        ASSERT_TRUE(mapped.IsOpen());
+        auto const format{DecompressBuf::Detect(mapped.View())};
+        if (!DecompressBuf::Supported(format)) {
+            continue;
+        }
+
+        // Файлы из нескольких gzip членов и zstd кадров, границы проходят внутри строк
+        bool good{};
+        ASSERT_TRUE(decompress(mapped.View(), good) == plain.View());
+        ASSERT_TRUE(good);
+
+        // Обрезанные данные, включая обрезанный хвост последнего члена (контрольная сумма gzip)
+        for (size_t const cut: {size_t{3}, mapped.View().size() / 2}) {
+            static_cast<void>(decompress(mapped.View().substr(0, mapped.View().size() - cut), good));
+            ASSERT_FALSE(good);
+        }
+    }
+}
+
+TEST(test_decompress_buf, zstd_frames) {
+    MappedFile const mapped{"ip_filter.tsv.zst"};
+    auto const frames{DecompressBuf::ZstdFrames(mapped.View())};
+#ifdef IP_FILTER_WITH_ZSTD
+    static constexpr size_t kNumFrames{4};
+
+    ASSERT_EQ(frames.size(), kNumFrames);
+    ASSERT_EQ(frames.front().data(), mapped.View().data());
+    ASSERT_EQ(frames.back().data() + frames.back().size(), mapped.View().data() + mapped.View().size());
+#else
+    ASSERT_TRUE(frames.empty());
+#endif
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "external_sort.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_external_sort, merge) {
+    static constexpr size_t kSizes[]{0, 1, 255, 256, 257, 10000, 100000};
+    static constexpr size_t kMaxMemory{4096};
+
+    std::mt19937 gen{9};
+    for (size_t const size: kSizes) {
+        std::vector<uint32_t> ethalon(size);
+        // Повторы, чтобы проверить слияние равных адресов
+        std::ranges::generate(ethalon, [&gen] { return static_cast<uint32_t>(gen() % 5000); });
+
+        ExternalSort sorter{kMaxMemory};
+        for (uint32_t const ip: ethalon) {
+            sorter.Push(ip);
+        }
+        sorter.Finish();
+        ASSERT_TRUE(sorter.Good());
+        size_t const num_runs{size < kMaxMemory / 8 ? 0 : (size + kMaxMemory / 8 - 1) / (kMaxMemory / 8)};
+        ASSERT_EQ(sorter.NumRuns(), num_runs);
+        // Больше kMaxFanIn серий сливаются в несколько проходов
+        size_t num_passes{};
+        static constexpr size_t kFanIn{ExternalSort::kMaxFanIn};
+        for (size_t left{num_runs}; left > kFanIn; left = (left + kFanIn - 1) / kFanIn) {
+            ++num_passes;
+        }
+        ASSERT_EQ(sorter.NumPasses(), num_passes);
+
+        std::vector<uint32_t> sorted{};
+        for (uint32_t ip{}; sorter.Next(ip);) {
+            sorted.push_back(ip);
+        }
+        std::ranges::sort(ethalon, std::greater{});
+        ASSERT_EQ(sorted, ethalon) << size;
+    }
+}
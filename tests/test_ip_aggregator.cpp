@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "ip_aggregator.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_aggregator, add_line) {
+    static std::vector<std::string> const in{
+        "1.2.3.4\t10\t100",
+        "1.2.3.5\t5\t50\r",
+        "1.2.4.4\t1\t0",
+        "1.2.3.4\t2\t7\textra",
+        "1.2.3.4\t2",
+        "1.2.3.4\tx\t1",
+        "1.2.3.256\t1\t1",
+        "1.2.3.4\t1\t1x",
+    };
+    static constexpr size_t kRejected{4};
+
+    IpAggregator per_address{};
+    IpAggregator per_24{24};
+    // Адрес разобран заранее, как при фильтрации: разбираются только счетчики
+    IpAggregator parsed{24};
+    for (auto const &line: in) {
+        per_address.AddLine(line);
+        uint32_t ip{};
+        auto const status{IpParser::Parse(IpParser::FirstField(line), ip)};
+        ASSERT_EQ(parsed.AddLine(line, status, ip), per_24.AddLine(line)) << line;
+    }
+    ASSERT_EQ(per_address.Rejected(), kRejected);
+    ASSERT_EQ(parsed.Rejected(), kRejected);
+    ASSERT_EQ(parsed.Size(), per_24.Size());
+    ASSERT_EQ(per_address.Size(), 3);
+    ASSERT_EQ(per_24.Size(), 2);
+
+    auto const top{per_24.Top(10)};
+    ASSERT_EQ(top.size(), 2);
+    ASSERT_EQ(IpAggregator::Format(top[0]), "1.2.3.0/24\t17\t157");
+    ASSERT_EQ(IpAggregator::Format(top[1]), "1.2.4.0/24\t1\t0");
+    auto const top_parsed{parsed.Top(10)};
+    ASSERT_EQ(top_parsed.size(), 2);
+    ASSERT_EQ(IpAggregator::Format(top_parsed[0]), IpAggregator::Format(top[0]));
+    ASSERT_EQ(IpAggregator::Format(top_parsed[1]), IpAggregator::Format(top[1]));
+
+    auto const top_address{per_address.Top(1)};
+    ASSERT_EQ(top_address.size(), 1);
+    ASSERT_EQ(IpAggregator::Format(top_address[0]), "1.2.3.4/32\t12\t107");
+}
+
+TEST(test_ip_aggregator, top_and_merge) {
+    static constexpr size_t kSize{100000};
+    static constexpr size_t kTop{20};
+    static constexpr int kLength{16};
+
+    std::mt19937 gen{12};
+    std::map<uint32_t, std::pair<uint64_t, uint64_t> > ethalon{};
+    IpAggregator first{kLength};
+    IpAggregator second{kLength};
+    for (size_t i{}; i < kSize; ++i) {
+        uint32_t const ip{static_cast<uint32_t>(gen())};
+        uint64_t const requests{gen() % 1000};
+        uint64_t const bytes{gen() % 100000};
+        auto &[sum_requests, sum_bytes]{ethalon[ip & 0xFFFF0000]};
+        sum_requests += requests;
+        sum_bytes += bytes;
+        (i % 2 == 0 ? first : second).Add(ip, requests, bytes);
+    }
+    first.Merge(second);
+    ASSERT_EQ(first.Size(), ethalon.size());
+
+    std::vector<IpAggregator::Entry> sorted{};
+    for (auto const &[key, sums]: ethalon) {
+        sorted.push_back({{key, kLength}, sums.first, sums.second});
+    }
+    std::ranges::sort(sorted, [](auto const &lhs, auto const &rhs) {
+        return std::tie(lhs.requests, lhs.bytes, lhs.prefix.value) > std::tie(rhs.requests, rhs.bytes, rhs.prefix.value);
+    });
+    auto const top{first.Top(kTop)};
+    ASSERT_EQ(top.size(), kTop);
+    for (size_t i{}; i < kTop; ++i) {
+        ASSERT_EQ(IpAggregator::Format(top[i]), IpAggregator::Format(sorted[i])) << i;
+    }
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "ip_bitmap.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_bitmap, descending) {
+    static constexpr size_t kSize{10000};
+
+    std::mt19937 gen{10};
+    std::vector<uint32_t> ethalon(kSize);
+    // Старшие биты из небольшого набора, чтобы адреса попадали в одни блоки и повторялись
+    std::ranges::generate(ethalon, [&gen] { return static_cast<uint32_t>(gen() % 8) << 29 | gen() % 5000; });
+    ethalon.push_back(0);
+    ethalon.push_back(~uint32_t{});
+
+    IpBitmap bitmap{true};
+    for (uint32_t const ip: ethalon) {
+        bitmap.Insert(ip);
+    }
+    std::ranges::sort(ethalon, std::greater{});
+    ASSERT_EQ(bitmap.Size(), ethalon.size());
+
+    std::vector<uint32_t> walked{};
+    bitmap.ForEachDescending([&walked](uint32_t const ip, uint32_t const count) {
+        walked.insert(walked.end(), count, ip);
+    });
+    ASSERT_EQ(walked, ethalon);
+
+    auto const [last, end]{std::ranges::unique(ethalon)};
+    ethalon.erase(last, end);
+    ASSERT_EQ(bitmap.Unique(), ethalon.size());
+}
+
+TEST(test_ip_bitmap, range) {
+    static std::vector<uint32_t> const in{0x00000000, 0x0000003F, 0x00000040, 0x0001FFFF, 0x00020000, 0x00020041};
+    static std::vector<uint32_t> const kEthalon{0x00020000, 0x0001FFFF, 0x00000040};
+
+    IpBitmap bitmap{};
+    for (uint32_t const ip: in) {
+        bitmap.Insert(ip);
+    }
+    std::vector<uint32_t> walked{};
+    bitmap.ForEachDescending(0x00000040, 0x00020040, [&walked](uint32_t const ip, uint32_t const count) {
+        ASSERT_EQ(count, 1);
+        walked.push_back(ip);
+    });
+    ASSERT_EQ(walked, kEthalon);
+}
+
+TEST(test_ip_bitmap, any_octet) {
+    static constexpr uint8_t kOctet{46};
+    static constexpr size_t kSize{100000};
+
+    std::mt19937 gen{11};
+    IpBitmap bitmap{};
+    std::vector<uint32_t> ethalon{};
+    for (size_t i{}; i < kSize; ++i) {
+        // Октеты из небольшого набора, чтобы совпадения были в каждой позиции
+        uint32_t ip{};
+        for (int octet{}; octet < 4; ++octet) {
+            ip = ip << 8 | static_cast<uint32_t>(kOctet - 2 + gen() % 4);
+        }
+        bitmap.Insert(ip);
+        ethalon.push_back(ip);
+    }
+    std::ranges::sort(ethalon, std::greater{});
+    auto const [last, end]{std::ranges::unique(ethalon)};
+    ethalon.erase(last, end);
+    std::erase_if(ethalon, [](uint32_t const ip) {
+        return (ip >> 24) != kOctet && (ip >> 16 & 0xFF) != kOctet && (ip >> 8 & 0xFF) != kOctet &&
+               (ip & 0xFF) != kOctet;
+    });
+
+    std::vector<uint32_t> walked{};
+    bitmap.ForEachAnyOctetDescending(kOctet, [&walked](uint32_t const ip, uint32_t) { walked.push_back(ip); });
+    ASSERT_EQ(walked, ethalon);
+}
+
+TEST(test_ip_bitmap, count) {
+    static constexpr uint32_t kIp{0x2E462E46};
+    static constexpr uint32_t kCount{1000};
+
+    IpBitmap counting{true};
+    IpBitmap unique{};
+    for (uint32_t i{}; i < kCount; ++i) {
+        counting.Insert(kIp);
+        unique.Insert(kIp);
+    }
+    ASSERT_EQ(counting.Count(kIp), kCount);
+    ASSERT_EQ(unique.Count(kIp), 1);
+    ASSERT_EQ(counting.Count(kIp + 1), 0);
+    ASSERT_TRUE(counting.Contains(kIp));
+    ASSERT_FALSE(counting.Contains(kIp - 1));
+    ASSERT_EQ(counting.Size(), kCount);
+    ASSERT_EQ(counting.Unique(), 1);
+}
+
+TEST(test_ip_bitmap, density) {
+    static std::vector<uint32_t> const kSparse{0x01000000, 0x02000000, 0x03000000, 0x03000001};
+
+    ASSERT_EQ(IpBitmap::Density({}), 0);
+    ASSERT_EQ(IpBitmap::Density(kSparse), 1);
+    std::vector<uint32_t> dense(1 << 12);
+    for (size_t i{}; i < dense.size(); ++i) {
+        dense[i] = 0x2E460000 | static_cast<uint32_t>(i % 1000);
+    }
+    ASSERT_EQ(IpBitmap::Density(dense), dense.size());
+}
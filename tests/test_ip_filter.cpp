@@ -3,10 +3,19 @@
 #include <filesystem>
 #include <cstdio>
 #include <algorithm>
+#include <limits>
 #include <boost/process.hpp>
 #include <boost/uuid/detail/md5.hpp>
 #include <boost/algorithm/hex.hpp>
 #include "ip_filter.h"
+#include "mapped_file.h"
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+#include <atomic>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 std::string md5sum(std::string const &input) {
     boost::uuids::detail::md5 md5;
@@ -22,6 +31,44 @@ std::string md5sum(std::string const &input) {
     return result;
 }
 
+/// md5 вывода фильтров для ip_filter.tsv
+#ifdef WSL_SPECIFIC_FLAG
+static std::string const kEthalonMd5{"B2A7E724E8AE0D27CAD3649C1ADAB35F"};
+#elifdef WINDOWS_SPECIFIC_FLAG
+static std::string const kEthalonMd5{"24E7A7B2270DAEE89C64D3CA5FB3DA1A"};
+#else
+static std::string const kEthalonMd5{};
+#endif
+
+/**
+ * @brief Вывод в std::cout во время func()
+ * @param func Функция без аргументов, false - ошибка
+ * @return Вывод, пустая строка при ошибке func()
+ */
+template<class Func>
+std::string capture(Func const &func) {
+    std::stringstream buffer{};
+    std::streambuf *const old_cout{std::cout.rdbuf(buffer.rdbuf())};
+    bool const done{func()};
+    std::cout.rdbuf(old_cout);
+    return done ? buffer.str() : std::string{};
+}
+
+/**
+ * @brief Вывод в std::cout во время func() с входными данными input в std::cin
+ * @param input Входные данные
+ * @param func Функция без аргументов, false - ошибка
+ * @return Вывод, пустая строка при ошибке func()
+ */
+template<class Func>
+std::string capture(std::string const &input, Func const &func) {
+    std::stringstream src{input};
+    std::streambuf *const old_cin{std::cin.rdbuf(src.rdbuf())};
+    std::string output{capture(func)};
+    std::cin.rdbuf(old_cin);
+    return output;
+}
+
 //--------------------TESTS--------------------
 
 TEST(test_ip_filter, ip_parsing) {
@@ -75,6 +122,31 @@ TEST(test_ip_filter, ip_sorting) {
     });
 }
 
+TEST(test_ip_filter, ip_packed_view) {
+    static std::vector<std::string> const in{
+        "128.128.128.128\t",
+        "255.255.255.255\t",
+        "1.1.1.1\t"
+    };
+    static std::vector<uint32_t> const kEthalonAscending{0x01010101, 0x80808080, 0xFFFFFFFF};
+
+    IpFilter ip_filter{};
+    ip_filter.ParsingInputVector(in);
+    ip_filter.Sorting(std::less{});
+
+    // Представление без копирования: адреса читаются из упакованного контейнера
+    auto const packed{ip_filter.GetPackedIPs()};
+    auto const ips{ip_filter.GetIPs()};
+    ASSERT_TRUE(std::ranges::equal(packed, kEthalonAscending));
+    ASSERT_EQ(ips.size(), packed.size());
+    ASSERT_EQ(ips.front().to_uint(), packed.front());
+
+    ip_filter.Sorting(std::greater{});
+    ASSERT_EQ(ip_filter.GetPackedIPs().data(), packed.data());
+    ASSERT_EQ(ips.front().to_string(), "255.255.255.255");
+    ASSERT_EQ(ips.back().to_string(), "1.1.1.1");
+}
+
 TEST(test_ip_filter, ip_filter_cxx23) {
     static std::string const kFileTest{"ip_filter.tsv"};
     static constexpr int kCxx23{23};
@@ -122,3 +194,639 @@ TEST(test_ip_filter, ip_filter_cxx17) {
     ASSERT_TRUE(false);
 #endif
 }
+
+TEST(test_ip_filter, ip_filter_resource) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+    static constexpr size_t kMinMappedBytes{1 << 10};
+
+    for (int const standard: kStandards) {
+        // Контейнер адресов берется у переданного ресурса, крупные массивы - отображением на больших страницах
+        CountingResource counting{};
+        HugePageResource huge{&counting, kMinMappedBytes};
+        IpFilter ip_filter{kFileTest, "", standard, &huge};
+
+        ASSERT_EQ(md5sum(capture([&ip_filter] { return ip_filter.Parsing(); })), kEthalonMd5);
+#ifdef WSL_SPECIFIC_FLAG
+        ASSERT_GT(huge.Mapped(), 0);
+#endif
+    }
+}
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+TEST(test_ip_filter, ip_filter_write_error) {
+    // Потерянный вывод - ошибка обработки
+    for (int const standard: {17, 23}) {
+        IpFilter ip_filter{"ip_filter.tsv", "/dev/full", standard};
+        ASSERT_FALSE(ip_filter.Parsing());
+    }
+}
+#endif
+
+TEST(test_ip_filter, ip_filter_threads) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+    static constexpr unsigned kThreads{4};
+
+    for (int const standard: kStandards) {
+        IpFilter ip_filter{kFileTest, "", standard};
+        ip_filter.SetThreads(kThreads);
+
+        ASSERT_EQ(md5sum(capture([&ip_filter] { return ip_filter.Parsing(); })), kEthalonMd5);
+    }
+
+    // Количество потоков ограничено сверху, вывод не меняется
+    IpFilter ip_filter{kFileTest};
+    ip_filter.SetThreads(0);
+    ASSERT_EQ(ip_filter.Threads(), 1);
+    ip_filter.SetThreads(std::numeric_limits<unsigned>::max());
+    ASSERT_EQ(ip_filter.Threads(), IpFilter::kMaxThreads);
+    ASSERT_EQ(md5sum(capture([&ip_filter] { return ip_filter.Parsing(); })), kEthalonMd5);
+}
+
+TEST(test_ip_filter, ip_filter_max_memory) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    // Серии по 256 адресов, входной файл сортируется в нескольких временных файлах
+    static constexpr size_t kMaxMemory{1};
+
+    IpFilter ip_filter{kFileTest};
+    ip_filter.SetMaxMemory(kMaxMemory);
+
+    ASSERT_EQ(md5sum(capture([&ip_filter] { return ip_filter.Parsing(); })), kEthalonMd5);
+}
+
+TEST(test_ip_filter, ip_filter_bitmap) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+
+    for (int const standard: kStandards) {
+        IpFilter ip_filter{kFileTest, "", standard};
+        ip_filter.SetStorage(IpFilter::Storage::kBitmap);
+
+        ASSERT_EQ(md5sum(capture([&ip_filter] { return ip_filter.Parsing(); })), kEthalonMd5);
+    }
+}
+
+TEST(test_ip_filter, ip_filter_unique) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kCxx17{17};
+    static constexpr int kCxx23{23};
+
+    auto const run{[](int const standard, IpFilter::Storage const storage, size_t const max_memory) {
+        IpFilter ip_filter{kFileTest, "", standard};
+        ip_filter.SetStorage(storage);
+        ip_filter.SetMaxMemory(max_memory);
+        ip_filter.SetUnique(true);
+
+        return capture([&ip_filter] { return ip_filter.Parsing(); });
+    }};
+
+    std::string const ethalon{run(kCxx23, IpFilter::Storage::kVector, 0)};
+    ASSERT_FALSE(ethalon.empty());
+    ASSERT_EQ(run(kCxx17, IpFilter::Storage::kVector, 0), ethalon);
+    ASSERT_EQ(run(kCxx17, IpFilter::Storage::kBitmap, 0), ethalon);
+    ASSERT_EQ(run(kCxx23, IpFilter::Storage::kBitmap, 0), ethalon);
+    ASSERT_EQ(run(kCxx17, IpFilter::Storage::kVector, 1), ethalon);
+
+    // Первая секция вывода (task_1) - все адреса по убыванию без повторов
+    std::vector<uint32_t> ips{};
+    std::stringstream lines{ethalon};
+    for (std::string line{}; std::getline(lines, line);) {
+        uint32_t ip{};
+        ASSERT_EQ(IpParser::Parse(line, ip), IpParser::Status::kOk);
+        if (!ips.empty() && ips.back() <= ip) {
+            break;
+        }
+        ips.push_back(ip);
+    }
+    IpBitmap bitmap{};
+    MappedFile::ForEachLine(MappedFile{kFileTest}.View(), [&bitmap](std::string_view const line) {
+        if (uint32_t ip{}; IpParser::Parse(IpParser::FirstField(line), ip) == IpParser::Status::kOk) {
+            bitmap.Insert(ip);
+        }
+    });
+    ASSERT_EQ(ips.size(), bitmap.Unique());
+}
+
+TEST(test_ip_filter, ip_filter_auto_storage) {
+    static constexpr int kCxx17{17};
+    static constexpr int kCxx23{23};
+    static constexpr size_t kNumLines{1 << 14};
+
+    // Плотные адреса с повторами: при Storage::kAuto и SetUnique() после парсинга выбирается битовая карта
+    std::string const dense_file{(std::filesystem::temp_directory_path() / "test_ip_filter_dense.tsv").string()};
+    {
+        std::ofstream dst{dense_file};
+        for (size_t i{}; i < kNumLines; ++i) {
+            dst << "46.70." << i % 7 << '.' << i * 31 % 256 << "\t1\t1\n";
+        }
+    }
+    auto const run{[](std::string const &file, int const standard, IpFilter::Storage const storage, bool const unique) {
+        IpFilter ip_filter{file, "", standard};
+        ip_filter.SetStorage(storage);
+        ip_filter.SetUnique(unique);
+
+        return capture([&ip_filter] { return ip_filter.Parsing(); });
+    }};
+
+    for (std::string const &file: {std::string{"ip_filter.tsv"}, dense_file}) {
+        for (bool const unique: {false, true}) {
+            std::string const ethalon{run(file, kCxx23, IpFilter::Storage::kVector, unique)};
+            ASSERT_FALSE(ethalon.empty());
+            ASSERT_EQ(run(file, kCxx23, IpFilter::Storage::kAuto, unique), ethalon) << file;
+            ASSERT_EQ(run(file, kCxx17, IpFilter::Storage::kAuto, unique), ethalon) << file;
+            ASSERT_EQ(run(file, kCxx17, IpFilter::Storage::kBitmap, unique), ethalon) << file;
+        }
+    }
+    std::filesystem::remove(dense_file);
+}
+
+TEST(test_ip_filter, ip_filter_aggregation) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+    static constexpr int kLength{8};
+    static constexpr size_t kTop{5};
+    static constexpr unsigned kThreads{4};
+
+    // Эталон: агрегация строк файла отдельным проходом
+    IpAggregator ethalon{kLength};
+    MappedFile::ForEachLine(MappedFile{kFileTest}.View(), [&ethalon](std::string_view const line) {
+        ethalon.AddLine(line);
+    });
+    std::string ethalon_tail{};
+    for (auto const &entry: ethalon.Top(kTop)) {
+        ethalon_tail += IpAggregator::Format(entry) + '\n';
+    }
+
+    for (int const standard: kStandards) {
+        for (unsigned const threads: {1u, kThreads}) {
+            IpFilter ip_filter{kFileTest, "", standard};
+            ip_filter.SetThreads(threads);
+            ip_filter.SetAggregation(kLength, kTop);
+
+            std::string const output{capture([&ip_filter] { return ip_filter.Parsing(); })};
+            ASSERT_TRUE(output.ends_with(ethalon_tail));
+
+            // Вывод фильтров не меняется
+            ASSERT_EQ(md5sum(output.substr(0, output.size() - ethalon_tail.size())), kEthalonMd5);
+        }
+    }
+}
+
+TEST(test_ip_filter, ip_filter_stats) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+    static constexpr unsigned kThreads{4};
+
+    // Эталон: строки файла и разбор каждого адреса
+    IpStats ethalon{};
+    MappedFile const mapped{kFileTest};
+    MappedFile::ForEachLine(mapped.View(), [&ethalon](std::string_view const line) {
+        uint32_t ip{};
+        ethalon.Count(IpParser::Parse(IpParser::FirstField(line), ip));
+    });
+
+    for (int const standard: kStandards) {
+        for (auto const storage: {IpFilter::Storage::kVector, IpFilter::Storage::kBitmap}) {
+            for (unsigned const threads: {1u, kThreads}) {
+                IpFilter ip_filter{kFileTest, "", standard};
+                ip_filter.SetStorage(storage);
+                ip_filter.SetThreads(threads);
+                ip_filter.SetStats(true);
+
+                std::string const output{capture([&ip_filter] { return ip_filter.Parsing(); })};
+                ASSERT_FALSE(output.empty());
+
+                auto const &stats{ip_filter.Stats()};
+                ASSERT_EQ(stats.bytes, mapped.View().size());
+                ASSERT_EQ(stats.lines, ethalon.lines);
+                ASSERT_EQ(stats.accepted, ethalon.accepted);
+                ASSERT_EQ(stats.rejected, ethalon.rejected);
+                ASSERT_EQ(stats.matches.task_1, ethalon.accepted);
+
+                auto const &[task_1, task_2, task_3, task_4, cidr, rules]{stats.matches};
+                auto const num_lines{static_cast<uint64_t>(std::ranges::count(output, '\n'))};
+                ASSERT_EQ(task_1 + task_2 + task_3 + task_4 + cidr, num_lines);
+                ASSERT_TRUE(rules.empty());
+                ASSERT_LE(stats.phases.parse + stats.phases.sort + stats.phases.filter, stats.phases.total);
+            }
+        }
+    }
+}
+
+TEST(test_ip_filter, ip_filter_follow) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+
+    // Конечный поток без запросов выводится как Parsing()
+    std::string const followed{capture([] {
+        IpFilter ip_filter{};
+        std::ifstream src{kFileTest};
+        return ip_filter.Follow(src);
+    })};
+    ASSERT_EQ(md5sum(followed), kEthalonMd5);
+
+    // Запрос выполняется после первой строки: сначала результаты по одному адресу, затем по всем
+    std::string const parsed{capture([] {
+        IpFilter ip_filter{kFileTest};
+        ip_filter.SetStorage(IpFilter::Storage::kVector);
+        ip_filter.SetUnique(true);
+        return ip_filter.Parsing();
+    })};
+    std::string const requested{capture([] {
+        IpFilter ip_filter{};
+        ip_filter.SetUnique(true);
+        ip_filter.RequestEmit();
+        std::ifstream src{kFileTest};
+        return ip_filter.Follow(src);
+    })};
+    ASSERT_FALSE(parsed.empty());
+    ASSERT_TRUE(requested.ends_with(parsed));
+    MappedFile const mapped{kFileTest};
+    std::string_view const first_line{mapped.View().substr(0, mapped.View().find('\n'))};
+    ASSERT_EQ(requested.substr(0, requested.find('\n')), IpParser::FirstField(first_line));
+}
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+TEST(test_ip_filter, ip_filter_follow_idle) {
+    static constexpr std::string_view kLine{"1.1.1.1\t1\t1\n"};
+    static constexpr auto kWaitStep{std::chrono::milliseconds{10}};
+    static constexpr int kMaxWaitSteps{500};
+
+    // Вывод результатов без новых строк: запрос RequestEmit() и периодический вывод
+    for (auto const interval: {std::chrono::milliseconds{}, std::chrono::milliseconds{50}}) {
+        std::array<int, 2> fds{};
+        ASSERT_EQ(pipe(fds.data()), 0);
+        std::atomic<size_t> emitted{};
+        IpFilter ip_filter{};
+        ip_filter.SetStats(true);
+        ip_filter.SetSink([&emitted](IpFilter::Section, uint32_t) {
+            emitted.fetch_add(1);
+        });
+        bool followed{};
+        std::thread reader{[&] { followed = ip_filter.Follow(fds[0], interval); }};
+        ASSERT_EQ(write(fds[1], kLine.data(), kLine.size()), static_cast<ssize_t>(kLine.size()));
+        // Ввод остается открытым, результаты должны быть выведены дважды до конца ввода
+        for (int step{}; step < kMaxWaitSteps && emitted.load() < 2; ++step) {
+            if (interval.count() == 0) {
+                ip_filter.RequestEmit();
+            }
+            std::this_thread::sleep_for(kWaitStep);
+        }
+        size_t const idle{emitted.load()};
+        close(fds[1]);
+        reader.join();
+        close(fds[0]);
+        ASSERT_TRUE(followed);
+        ASSERT_GE(idle, 2U);
+        ASSERT_GT(emitted.load(), idle);
+        ASSERT_EQ(ip_filter.Stats().accepted, 1U);
+    }
+}
+#endif
+
+TEST(test_ip_filter, ip_filter_index) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+
+    std::string const index_file{(std::filesystem::temp_directory_path() / "test_ip_filter_index.idx").string()};
+    std::filesystem::remove(index_file);
+
+    auto const run{[&index_file](int const standard, bool const save, bool const unique, IpStats &stats) {
+        IpFilter ip_filter{kFileTest, "", standard};
+        if (save) {
+            ip_filter.SetSaveIndex(index_file);
+        } else {
+            ip_filter.SetLoadIndex(index_file);
+        }
+        ip_filter.SetUnique(unique);
+
+        std::string output{capture([&ip_filter] { return ip_filter.Parsing(); })};
+        stats = ip_filter.Stats();
+        return output;
+    }};
+
+    IpStats stats{};
+    std::string const saved{run(kStandards[0], true, false, stats)};
+    ASSERT_NE(stats.bytes, 0u);
+    ASSERT_TRUE(std::filesystem::exists(index_file));
+    for (int const standard: kStandards) {
+        // Снимок загружается вместо парсинга: входной файл не читается
+        ASSERT_EQ(run(standard, false, false, stats), saved);
+        ASSERT_EQ(stats.bytes, 0u);
+        // Исходный файл не изменился, снимок используется повторно
+        ASSERT_EQ(run(standard, true, false, stats), saved);
+        ASSERT_EQ(stats.bytes, 0u);
+    }
+    ASSERT_EQ(md5sum(saved), kEthalonMd5);
+
+    IpStats unique_stats{};
+    std::string const unique{run(kStandards[0], false, true, unique_stats)};
+    ASSERT_EQ(unique_stats.bytes, 0u);
+    IpFilter ip_filter{kFileTest};
+    ip_filter.SetStorage(IpFilter::Storage::kBitmap);
+    ip_filter.SetUnique(true);
+    ASSERT_FALSE(unique.empty());
+    ASSERT_EQ(unique, capture([&ip_filter] { return ip_filter.Parsing(); }));
+
+    std::filesystem::remove(index_file);
+}
+
+TEST(test_ip_filter, ip_filter_index_stdin) {
+    std::string const index_file{(std::filesystem::temp_directory_path() / "test_ip_filter_stdin.idx").string()};
+    std::filesystem::remove(index_file);
+
+    // Без входного файла снимок не используется повторно: каждый запуск разбирает свой std::cin
+    auto const run{[&index_file](std::string const &input) {
+        IpFilter ip_filter{"", ""};
+        ip_filter.SetSaveIndex(index_file);
+        return capture(input, [&ip_filter] { return ip_filter.Parsing(); });
+    }};
+
+    ASSERT_EQ(run("1.1.1.1\t1\t1\n"), "1.1.1.1\n1.1.1.1\n");
+    ASSERT_EQ(run("9.9.9.9\t1\t1\n"), "9.9.9.9\n");
+    // Снимок перезаписан последним запуском
+    IpFilter ip_filter{"", ""};
+    ip_filter.SetLoadIndex(index_file);
+    ASSERT_EQ(capture("", [&ip_filter] { return ip_filter.Parsing(); }), "9.9.9.9\n");
+
+    std::filesystem::remove(index_file);
+}
+
+TEST(test_ip_filter, ip_filter_stdin_pipeline) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr int kStandards[]{17, 23};
+    static constexpr unsigned kThreads{3};
+    // Входные данные больше нескольких блоков конвейера, строки переходят через границы блоков
+    static constexpr int kRepeats{150};
+
+    std::string input{};
+    MappedFile const mapped{kFileTest};
+    for (int i{}; i < kRepeats; ++i) {
+        input += mapped.View();
+    }
+    std::string const repeated_file{(std::filesystem::temp_directory_path() / "test_ip_filter_stdin.tsv").string()};
+    std::ofstream{repeated_file} << input;
+
+    for (int const standard: kStandards) {
+        IpFilter from_file{repeated_file, "", standard};
+        from_file.SetStorage(IpFilter::Storage::kVector);
+        std::string const ethalon{capture([&from_file] { return from_file.Parsing(); })};
+        ASSERT_FALSE(ethalon.empty());
+
+        IpFilter from_stdin{"", "", standard};
+        from_stdin.SetThreads(kThreads);
+        from_stdin.SetStats(true);
+        std::string const piped{capture(input, [&from_stdin] { return from_stdin.Parsing(); })};
+
+        ASSERT_EQ(piped, ethalon);
+        ASSERT_EQ(from_stdin.Stats().bytes, input.size());
+        ASSERT_EQ(from_stdin.Stats().lines, from_file.Stats().matches.task_1);
+    }
+    std::filesystem::remove(repeated_file);
+}
+
+TEST(test_ip_filter, ip_filter_compressed) {
+    static constexpr unsigned kThreads{3};
+
+    for (std::string const file: {"ip_filter.tsv.gz", "ip_filter.tsv.zst"}) {
+        bool const supported{DecompressBuf::Supported(DecompressBuf::Detect(MappedFile{file}.View()))};
+        for (auto const storage: {IpFilter::Storage::kVector, IpFilter::Storage::kBitmap}) {
+            for (unsigned const threads: {1u, kThreads}) {
+                IpFilter ip_filter{file};
+                ip_filter.SetStorage(storage);
+                ip_filter.SetThreads(threads);
+
+                std::string const output{capture([&ip_filter] { return ip_filter.Parsing(); })};
+
+                ASSERT_EQ(!output.empty(), supported);
+                if (!supported) {
+                    continue;
+                }
+                ASSERT_EQ(ip_filter.Stats().bytes, MappedFile{"ip_filter.tsv"}.View().size());
+                ASSERT_EQ(md5sum(output), kEthalonMd5);
+            }
+        }
+    }
+}
+
+TEST(test_ip_filter, ip_filter_rules) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    auto const dir{std::filesystem::temp_directory_path()};
+    std::string const rules_file{(dir / "test_ip_filter_rules.txt").string()};
+    std::string const rule_files[]{
+        (dir / "test_ip_filter_rule_2.txt").string(), (dir / "test_ip_filter_rule_3.txt").string(),
+        (dir / "test_ip_filter_rule_4.txt").string(), (dir / "test_ip_filter_rule_3_cidr.txt").string(),
+    };
+    {
+        std::ofstream dst{rules_file};
+        dst << "1.*.*.* " << rule_files[0] << "\n"
+                "46.70.*.* " << rule_files[1] << "\n"
+                "any==46 " << rule_files[2] << "\n"
+                "46.70.0.0/16 " << rule_files[3] << "\n";
+    }
+    auto const read{[](std::string const &file) {
+        MappedFile const mapped{file};
+        return std::string{mapped.View()};
+    }};
+
+    // Вывод правил совпадает с частями основного вывода соответствующих фильтров
+    for (auto const storage: {IpFilter::Storage::kVector, IpFilter::Storage::kBitmap}) {
+        for (size_t const max_memory: {size_t{}, size_t{1}}) {
+            IpFilter ip_filter{kFileTest};
+            ip_filter.SetStorage(storage);
+            ip_filter.SetMaxMemory(max_memory);
+            ASSERT_TRUE(ip_filter.LoadRulesFile(rules_file));
+
+            std::stringstream buffer{capture([&ip_filter] { return ip_filter.Parsing(); })};
+            ASSERT_FALSE(buffer.str().empty());
+
+            auto const &matches{ip_filter.Stats().matches};
+            ASSERT_EQ(matches.rules, (std::vector<uint64_t>{matches.task_2, matches.task_3, matches.task_4,
+                                                            matches.task_3}));
+            std::vector<std::string> lines{};
+            for (std::string line{}; std::getline(buffer, line);) {
+                lines.push_back(line + '\n');
+            }
+            auto const part{[&lines](uint64_t const beg, uint64_t const size) {
+                std::string text{};
+                for (auto const &line: std::span{lines}.subspan(beg, size)) {
+                    text += line;
+                }
+                return text;
+            }};
+            uint64_t const task_3_beg{matches.task_1 + matches.task_2};
+            ASSERT_EQ(read(rule_files[0]), part(matches.task_1, matches.task_2));
+            ASSERT_EQ(read(rule_files[1]), part(task_3_beg, matches.task_3));
+            ASSERT_EQ(read(rule_files[2]), part(task_3_beg + matches.task_3, matches.task_4));
+            ASSERT_EQ(read(rule_files[3]), read(rule_files[1]));
+        }
+    }
+    std::filesystem::remove(rules_file);
+    for (auto const &file: rule_files) {
+        std::filesystem::remove(file);
+    }
+}
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+TEST(test_ip_filter, ip_filter_rules_fd_limit) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr rlim_t kMaxFiles{64};
+    static constexpr size_t kNumRules{256};
+
+    auto const dir{std::filesystem::temp_directory_path() / "test_ip_filter_many_rules"};
+    std::filesystem::create_directories(dir);
+    std::string const rules_file{(dir / "rules.txt").string()};
+    {
+        std::ofstream dst{rules_file};
+        for (size_t i{}; i < kNumRules; ++i) {
+            dst << "any==" << i << ' ' << (dir / (std::to_string(i) + ".txt")).string() << '\n';
+        }
+    }
+    IpFilter plain{kFileTest};
+    std::string const ethalon{capture([&plain] { return plain.Parsing(); })};
+    ASSERT_FALSE(ethalon.empty());
+
+    // Правил больше, чем можно открыть файлов: вывод правил не уходит в std::cout, входной файл читается
+    rlimit limit{};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limit), 0);
+    rlimit const lowered{std::min(kMaxFiles, limit.rlim_cur), limit.rlim_max};
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &lowered), 0);
+    IpFilter ip_filter{kFileTest};
+    bool const loaded{ip_filter.LoadRulesFile(rules_file)};
+    std::string const output{loaded ? capture([&ip_filter] { return ip_filter.Parsing(); }) : std::string{}};
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(output, ethalon);
+
+    auto const &matches{ip_filter.Stats().matches.rules};
+    ASSERT_EQ(matches.size(), kNumRules);
+    uint64_t total{};
+    for (size_t i{}; i < kNumRules; ++i) {
+        std::ifstream src{dir / (std::to_string(i) + ".txt")};
+        ASSERT_TRUE(src.is_open()) << i;
+        auto const lines{std::count(std::istreambuf_iterator<char>{src}, std::istreambuf_iterator<char>{}, '\n')};
+        ASSERT_EQ(static_cast<uint64_t>(lines), matches[i]) << i;
+        total += matches[i];
+    }
+    ASSERT_NE(total, 0U);
+
+    // Файл вывода правила не создается - правила не загружаются
+    {
+        std::ofstream dst{rules_file};
+        dst << "any==46 " << (dir / "missing" / "46.txt").string() << '\n';
+    }
+    ASSERT_FALSE(ip_filter.LoadRulesFile(rules_file));
+    std::filesystem::remove_all(dir);
+}
+#endif
+
+TEST(test_ip_filter, ip_filter_limit) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr size_t kLimits[]{1, 5, 1000000};
+
+    auto const run{[](bool const unique, size_t const limit, IpStats &stats) {
+        IpFilter ip_filter{kFileTest};
+        ip_filter.SetStorage(IpFilter::Storage::kVector);
+        ip_filter.SetUnique(unique);
+        ip_filter.SetLimit(limit);
+
+        std::string output{capture([&ip_filter] { return ip_filter.Parsing(); })};
+        stats = ip_filter.Stats();
+        return output;
+    }};
+
+    // Вывод с ограничением - начало каждой секции полного вывода
+    for (bool const unique: {false, true}) {
+        IpStats full_stats{};
+        std::string const full{run(unique, 0, full_stats)};
+        std::vector<std::string> lines{};
+        std::stringstream src{full};
+        for (std::string line{}; std::getline(src, line);) {
+            lines.push_back(line + '\n');
+        }
+        for (size_t const limit: kLimits) {
+            std::string ethalon{};
+            size_t beg{};
+            for (uint64_t const matches: {full_stats.matches.task_1, full_stats.matches.task_2,
+                                          full_stats.matches.task_3, full_stats.matches.task_4}) {
+                for (size_t i{}; i < std::min<size_t>(limit, matches); ++i) {
+                    ethalon += lines[beg + i];
+                }
+                beg += matches;
+            }
+            IpStats stats{};
+            ASSERT_EQ(run(unique, limit, stats), ethalon) << limit << ' ' << unique;
+            ASSERT_EQ(stats.matches.task_1, std::min<uint64_t>(limit, full_stats.matches.task_1));
+            ASSERT_EQ(stats.phases.sort.count(), 0);
+        }
+    }
+}
+
+TEST(test_ip_filter, ip_filter_feed) {
+    static std::string const kFileTest{"ip_filter.tsv"};
+    static constexpr size_t kChunkSizes[]{1, 7, 4096, 1 << 20};
+
+    MappedFile const mapped{kFileTest};
+    std::string_view const text{mapped.View()};
+
+    // Части разного размера, строки разрезаются границами частей; без получателя вывод как у Parsing()
+    for (size_t const chunk_size: kChunkSizes) {
+        IpFilter ip_filter{};
+        std::string const output{capture([&ip_filter, text, chunk_size] {
+            for (size_t beg{}; beg < text.size(); beg += chunk_size) {
+                ip_filter.Feed(text.substr(beg, chunk_size));
+            }
+            return ip_filter.Finish();
+        })};
+
+        ASSERT_EQ(ip_filter.Stats().bytes, text.size());
+        ASSERT_EQ(md5sum(output), kEthalonMd5) << chunk_size;
+    }
+
+    // Получатель видит те же адреса по секциям, второй набор после Finish() начинается заново,
+    // в том числе суммы агрегации
+    static constexpr int kLength{8};
+    static constexpr size_t kTop{5};
+    IpAggregator ethalon{kLength};
+    MappedFile::ForEachLine(text, [&ethalon](std::string_view const line) { ethalon.AddLine(line); });
+    std::string ethalon_tail{};
+    for (auto const &entry: ethalon.Top(kTop)) {
+        ethalon_tail += IpAggregator::Format(entry) + '\n';
+    }
+
+    IpFilter ip_filter{};
+    ip_filter.SetAggregation(kLength, kTop);
+    std::vector<std::vector<uint32_t> > sections(5);
+    ip_filter.SetSink([&sections](IpFilter::Section const section, uint32_t const ip) {
+        sections[static_cast<size_t>(section)].push_back(ip);
+    });
+    std::string const cidr_file{(std::filesystem::temp_directory_path() / "test_ip_filter_feed.txt").string()};
+    {
+        std::ofstream dst{cidr_file};
+        dst << "46.0.0.0/8\n";
+    }
+    ASSERT_TRUE(ip_filter.LoadCidrFile(cidr_file));
+    std::filesystem::remove(cidr_file);
+    for (int batch{}; batch < 2; ++batch) {
+        std::ranges::for_each(sections, [](auto &ips) { ips.clear(); });
+        std::string_view const head{text.substr(0, text.size() / 2 + 3)};
+        std::string const output{capture([&ip_filter, text, head] {
+            ip_filter.Feed(head);
+            ip_filter.Feed(text.substr(head.size()));
+            return ip_filter.Finish();
+        })};
+        ASSERT_EQ(output, ethalon_tail) << batch;
+
+        auto const &matches{ip_filter.Stats().matches};
+        ASSERT_EQ(sections[0].size(), matches.task_1);
+        ASSERT_EQ(sections[1].size(), matches.task_2);
+        ASSERT_EQ(sections[2].size(), matches.task_3);
+        ASSERT_EQ(sections[3].size(), matches.task_4);
+        ASSERT_EQ(sections[4].size(), matches.cidr);
+        ASSERT_TRUE(std::ranges::is_sorted(sections[0], std::greater{}));
+        ASSERT_TRUE(std::ranges::all_of(sections[3], Otus::task_4));
+        ASSERT_TRUE(std::ranges::all_of(sections[4], [](uint32_t const ip) { return ip >> 24 == 46; }));
+        ASSERT_EQ(std::ranges::count_if(sections[0], [](uint32_t const ip) { return ip >> 24 == 46; }),
+                  static_cast<std::ptrdiff_t>(matches.cidr));
+    }
+}
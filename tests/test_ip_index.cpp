@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <vector>
+#include "ip_index.h"
+
+namespace {
+    std::string index_path(std::string const &name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+}
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_index, save_load) {
+    static constexpr size_t kSize{5000};
+    static IpIndex::Source const kSource{123, 456};
+
+    std::mt19937 gen{17};
+    std::vector<uint32_t> sorted(kSize);
+    std::ranges::generate(sorted, [&gen] { return static_cast<uint32_t>(gen()); });
+    sorted.push_back(0);
+    sorted.push_back(~uint32_t{});
+    std::ranges::sort(sorted, std::greater{});
+
+    std::string const file{index_path("test_ip_index_save_load.idx")};
+    ASSERT_TRUE(IpIndex::Save(file, sorted, kSource));
+
+    IpIndex index{};
+    ASSERT_TRUE(index.Load(file));
+    ASSERT_TRUE(index.IsOpen());
+    ASSERT_EQ(index.GetSource(), kSource);
+    ASSERT_TRUE(std::ranges::equal(index.Addresses(), sorted));
+
+    for (uint32_t octet{}; octet < 256; ++octet) {
+        std::vector<uint32_t> ethalon{};
+        std::ranges::copy_if(sorted, std::back_inserter(ethalon), [octet](uint32_t const ip) { return ip >> 24 == octet; });
+        ASSERT_TRUE(std::ranges::equal(index.FirstOctet(static_cast<uint8_t>(octet)), ethalon));
+    }
+
+    for (IpPrefix const prefix: {IpPrefix{0x2E460000, 16}, IpPrefix{0x01000000, 8}, IpPrefix{0, 0}, IpPrefix{0x40000000, 2}}) {
+        std::vector<uint32_t> ethalon{};
+        std::ranges::copy_if(sorted, std::back_inserter(ethalon), [&prefix](uint32_t const ip) { return prefix(ip); });
+        ASSERT_TRUE(std::ranges::equal(index.EqualRange(prefix), ethalon));
+    }
+    index.Close();
+    std::filesystem::remove(file);
+}
+
+TEST(test_ip_index, corrupted) {
+    static std::vector<uint32_t> const sorted{0x0A000003, 0x0A000002, 0x01010101};
+
+    std::string const file{index_path("test_ip_index_corrupted.idx")};
+    ASSERT_TRUE(IpIndex::Save(file, sorted, {}));
+
+    // Изменение адреса обнаруживается контрольной суммой
+    {
+        std::fstream stream{file, std::ios::in | std::ios::out | std::ios::binary};
+        stream.seekp(-1, std::ios::end);
+        stream.put('\x7F');
+    }
+    IpIndex index{};
+    ASSERT_FALSE(index.Load(file));
+    ASSERT_FALSE(index.IsOpen());
+    ASSERT_TRUE(index.Addresses().empty());
+
+    // Обрезанный файл
+    ASSERT_TRUE(IpIndex::Save(file, sorted, {}));
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - sizeof(uint32_t));
+    ASSERT_FALSE(index.Load(file));
+
+    ASSERT_FALSE(index.Load(index_path("test_ip_index_missing.idx")));
+    std::filesystem::remove(file);
+}
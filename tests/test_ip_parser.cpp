@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "ip_parser.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_parser, same_rejections_as_ip_parsing) {
+    static std::vector<std::tuple<std::string, IpParser::Status> > const in{
+        {"255.255.255.255\t", IpParser::Status::kOk},
+        {"255.255.255.255.255\t", IpParser::Status::kTooLong},
+        {"2555.255.255.255\t", IpParser::Status::kTooLong},
+        {"255.2555.255.255\t", IpParser::Status::kTooLong},
+        {"255.255.2555.255\t", IpParser::Status::kTooLong},
+        {"255.255.255.2555\t", IpParser::Status::kTooLong},
+        {"255.255.255\t", IpParser::Status::kBadDots},
+        {"255.255.255.255", IpParser::Status::kOk},
+        {"xxx.255.255.255\t", IpParser::Status::kBadChar},
+        {"abc.255.255.255\t", IpParser::Status::kBadChar},
+    };
+    for (auto const &[line, status]: in) {
+        uint32_t ip{};
+        ASSERT_EQ(IpParser::Parse(IpParser::FirstField(line), ip), status) << line;
+        if (status == IpParser::Status::kOk) {
+            ASSERT_EQ(ip, 0xFFFFFFFFu);
+        }
+    }
+}
+
+TEST(test_ip_parser, octets) {
+    static std::vector<std::tuple<std::string, IpParser::Status, uint32_t> > const in{
+        {"1.2.3.4\t5\t6", IpParser::Status::kOk, 0x01020304u},
+        {"0.0.0.0", IpParser::Status::kOk, 0u},
+        {"46.70.113.73\t", IpParser::Status::kOk, 0x2E467149u},
+        {"256.1.1.1\t", IpParser::Status::kBadOctet, 0},
+        {"1.2.3.04\t", IpParser::Status::kBadOctet, 0},
+        {"1..3.4\t", IpParser::Status::kBadOctet, 0},
+        {".1.2.3\t", IpParser::Status::kBadOctet, 0},
+        {"1.2.3.\t", IpParser::Status::kBadOctet, 0},
+        {"1.2.3.4 \t", IpParser::Status::kBadChar, 0},
+        {"1.2.3.\xB4\t", IpParser::Status::kBadChar, 0},
+        {"\t1.2.3.4", IpParser::Status::kBadDots, 0},
+        {"", IpParser::Status::kBadDots, 0},
+        {"1.2.3.4.5.6.7.8.9", IpParser::Status::kTooLong, 0},
+    };
+    for (auto const &[line, status, ethalon]: in) {
+        uint32_t ip{};
+        ASSERT_EQ(IpParser::Parse(IpParser::FirstField(line), ip), status) << line;
+        if (status == IpParser::Status::kOk) {
+            ASSERT_EQ(ip, ethalon) << line;
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+#include "ip_predicates.h"
+
+using IpMatch::kAny;
+
+static_assert(IpMatch::Octets<46, 70, kAny, kAny>{}(0x2E467149u));
+static_assert(!IpMatch::Octets<46, 70, kAny, kAny>{}(0x2E477149u));
+static_assert(IpMatch::Octets<46, 70, kAny, kAny>::kIsPrefix);
+static_assert(!IpMatch::Octets<kAny, 70, kAny, kAny>::kIsPrefix);
+static_assert(IpMatch::Octets<kAny, kAny, kAny, kAny>::Prefix().length == 0);
+static_assert(IpMatch::Octets<1, 2, 3, 4>::Prefix().length == 32);
+static_assert(IpMatch::AnyOctet<46>{}(0x0102032Eu));
+static_assert(!IpMatch::AnyOctet<46>{}(0x2D2F0000u));
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_predicates, compose) {
+    using is_46_70 = IpMatch::Octets<46, 70, kAny, kAny>;
+    using has_46 = IpMatch::AnyOctet<46>;
+    using is_1 = IpMatch::Octets<1, kAny, kAny, kAny>;
+
+    static constexpr uint32_t kIps[]{0x2E467149u, 0x01022E04u, 0x01020304u, 0x2F2F2F2Fu, 0x00002E00u};
+    for (uint32_t const ip: kIps) {
+        ASSERT_EQ((IpMatch::AnyOf<is_1, has_46>{}(ip)), is_1{}(ip) || has_46{}(ip));
+        ASSERT_EQ((IpMatch::AllOf<is_1, has_46>{}(ip)), is_1{}(ip) && has_46{}(ip));
+        ASSERT_EQ(is_46_70{}(ip), is_46_70::Prefix()(ip));
+        ASSERT_EQ(has_46{}(boost::asio::ip::address_v4{ip}), has_46{}(ip));
+    }
+}
@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "ip_prefix.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_prefix, equal_range) {
+    static constexpr int kSize{5000};
+    static IpPrefix const kPrefixes[]{
+        {0x01000000, 8}, {0x2E460000, 16}, {0x2E460000, 8}, {0xFF000000, 8}, {0x00000000, 8},
+        {0x0A0B0C0D, 32}, {0x00000000, 0}, {0x7B000000, 1},
+    };
+
+    std::mt19937 gen{7};
+    std::uniform_int_distribution<uint32_t> octet{0, 0xFF};
+    std::vector<uint32_t> ips(kSize);
+    // Маленький набор первых октетов, чтобы префиксы часто совпадали
+    std::ranges::generate(ips, [&] {
+        static constexpr uint32_t kFirst[]{0x01, 0x2E, 0x7B, 0xFF};
+        uint32_t const first{kFirst[octet(gen) % std::size(kFirst)]};
+        uint32_t const second{octet(gen) % 2 ? 0x46 : octet(gen)};
+        return first << 24 | second << 16 | octet(gen) << 8 | octet(gen);
+    });
+    ips.push_back(0x0A0B0C0D);
+    std::ranges::sort(ips, std::greater{});
+
+    for (auto const &prefix: kPrefixes) {
+        std::vector<uint32_t> ethalon{};
+        std::ranges::copy_if(ips, std::back_inserter(ethalon), prefix);
+        auto const range{prefix.EqualRange(std::span<uint32_t const>{ips}, [](uint32_t const ip) { return ip; })};
+        ASSERT_TRUE(std::ranges::equal(range, ethalon)) << prefix.value << '/' << prefix.length;
+    }
+}
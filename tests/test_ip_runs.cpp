@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "ip_runs.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_runs, descending) {
+    static constexpr size_t kSize{10000};
+    static constexpr size_t kBufferSize{64};
+
+    std::mt19937 gen{16};
+    std::vector<uint32_t> ethalon(kSize);
+    // Небольшой диапазон значений, чтобы адреса повторялись в разных сериях
+    std::ranges::generate(ethalon, [&gen] { return static_cast<uint32_t>(gen() % 3000) << 20; });
+
+    IpRuns runs{kBufferSize};
+    for (uint32_t const ip: ethalon) {
+        runs.Insert(ip);
+    }
+    runs.Seal();
+    ASSERT_EQ(runs.Size(), ethalon.size());
+    // Серии сливаются по размеру, их число растет логарифмически
+    ASSERT_LE(runs.NumRuns(), 16u);
+
+    std::ranges::sort(ethalon, std::greater{});
+    std::vector<uint32_t> walked{};
+    runs.ForEachDescending([&walked](uint32_t const ip) { walked.push_back(ip); });
+    ASSERT_EQ(walked, ethalon);
+}
+
+TEST(test_ip_runs, range) {
+    static std::vector<uint32_t> const in{0x00000000, 0x0000003F, 0x00000040, 0x0001FFFF, 0x00020000, 0x00020041};
+    static std::vector<uint32_t> const kEthalon{0x00020000, 0x0001FFFF, 0x00000040};
+    static constexpr size_t kBufferSize{2};
+
+    IpRuns runs{kBufferSize};
+    for (uint32_t const ip: in) {
+        runs.Insert(ip);
+    }
+    runs.Seal();
+
+    std::vector<uint32_t> walked{};
+    runs.ForEachDescending(0x00000040, 0x00020000, [&walked](uint32_t const ip) { walked.push_back(ip); });
+    ASSERT_EQ(walked, kEthalon);
+}
+
+TEST(test_ip_runs, incremental) {
+    static constexpr size_t kBufferSize{4};
+
+    IpRuns runs{kBufferSize};
+    std::vector<uint32_t> inserted{};
+    // Обход между вставками видит все адреса серий без пересортировки
+    for (uint32_t ip{}; ip < 100; ++ip) {
+        uint32_t const value{(ip * 37) % 101};
+        runs.Insert(value);
+        inserted.push_back(value);
+        runs.Seal();
+
+        std::vector<uint32_t> walked{};
+        runs.ForEachDescending([&walked](uint32_t const elm) { walked.push_back(elm); });
+        std::vector<uint32_t> ethalon{inserted};
+        std::ranges::sort(ethalon, std::greater{});
+        ASSERT_EQ(walked, ethalon);
+    }
+}
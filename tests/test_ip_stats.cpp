@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include "ip_stats.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_stats, count) {
+    IpStats stats{};
+    stats.Count(IpParser::Status::kOk);
+    stats.Count(IpParser::Status::kOk);
+    stats.Count(IpParser::Status::kTooLong);
+    stats.Count(IpParser::Status::kBadOctet);
+
+    IpStats part{};
+    part.bytes = 10;
+    part.Count(IpParser::Status::kBadChar);
+    part.Count(IpParser::Status::kBadDots);
+    stats.Merge(part);
+
+    ASSERT_EQ(stats.bytes, 10);
+    ASSERT_EQ(stats.lines, 6);
+    ASSERT_EQ(stats.accepted, 2);
+    ASSERT_EQ(stats.Rejected(), 4);
+    ASSERT_EQ(stats.rejected, (std::array<uint64_t, IpStats::kNumReasons>{1, 1, 1, 1}));
+}
+
+TEST(test_ip_stats, json) {
+    IpStats stats{};
+    stats.bytes = 100;
+    stats.Count(IpParser::Status::kOk);
+    stats.Count(IpParser::Status::kBadChar);
+    stats.matches.task_1 = 1;
+    stats.phases.parse = std::chrono::nanoseconds{42};
+
+    ASSERT_EQ(stats.ToJson(),
+              "{\"bytes\":100,\"lines\":2,\"accepted\":1,"
+              "\"rejected\":{\"too_long\":0,\"bad_dots\":0,\"bad_char\":1,\"bad_octet\":0},"
+              "\"matches\":{\"task_1\":1,\"task_2\":0,\"task_3\":0,\"task_4\":0,\"cidr\":0},"
+              "\"memory\":{\"allocations\":0,\"peak_bytes\":0,\"max_rss_kb\":0},"
+              "\"phases_ns\":{\"read\":0,\"parse\":42,\"sort\":0,\"filter\":0,\"write\":0,\"total\":0}}");
+}
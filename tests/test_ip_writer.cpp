@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <boost/asio/ip/address_v4.hpp>
+#include "ip_writer.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_ip_writer, file) {
+    static constexpr int kNumIps{100000};
+
+    auto const file{std::filesystem::temp_directory_path() / "test_ip_writer.txt"};
+    std::string ethalon{};
+    {
+        IpWriter writer{file.string()};
+        ASSERT_TRUE(writer.IsFile());
+        std::mt19937 gen{3};
+        for (int i{}; i < kNumIps; ++i) {
+            // Октеты разной длины: 0..9, 10..99, 100..255
+            uint32_t const ip{i < 256 ? static_cast<uint32_t>(i) * 0x01010101u : static_cast<uint32_t>(gen())};
+            writer.Write(ip);
+            ethalon += boost::asio::ip::address_v4{ip}.to_string() + '\n';
+        }
+        writer.Write("255.255.255.255");
+        ethalon += "255.255.255.255\n";
+    }
+    std::ifstream src{file, std::ios::binary};
+    std::string const output{std::istreambuf_iterator<char>{src}, std::istreambuf_iterator<char>{}};
+    src.close();
+    std::filesystem::remove(file);
+    ASSERT_EQ(output, ethalon);
+}
+
+TEST(test_ip_writer, cout) {
+    std::stringstream buffer{};
+    std::streambuf *old_cout{std::cout.rdbuf()};
+
+    IpWriter writer{};
+    ASSERT_FALSE(writer.IsFile());
+    writer.Write(0x2E467149u);
+    std::cout.rdbuf(buffer.rdbuf());
+    writer.Flush();
+    std::cout.rdbuf(old_cout);
+
+    ASSERT_EQ(buffer.str(), "46.70.113.73\n");
+}
+
+#ifndef WINDOWS_SPECIFIC_FLAG
+TEST(test_ip_writer, write_error) {
+    // Запись в /dev/full завершается ENOSPC
+    IpWriter writer{"/dev/full"};
+    ASSERT_TRUE(writer.IsFile());
+    ASSERT_TRUE(writer.Good());
+    writer.Write(0x2E467149u);
+    writer.Flush();
+    ASSERT_FALSE(writer.Good());
+}
+#endif
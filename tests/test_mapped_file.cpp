@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+namespace {
+    std::vector<std::string> lines(std::string_view const text) {
+        std::vector<std::string> result{};
+        MappedFile::ForEachLine(text, [&result](std::string_view const line) { result.emplace_back(line); });
+        return result;
+    }
+}
+
+//--------------------TESTS--------------------
+
+TEST(test_mapped_file, for_each_line) {
+    ASSERT_EQ(lines(""), std::vector<std::string>{});
+    ASSERT_EQ(lines("a\n"), std::vector<std::string>{"a"});
+    ASSERT_EQ(lines("a\nb"), (std::vector<std::string>{"a", "b"}));
+    ASSERT_EQ(lines("a\n\nb\n"), (std::vector<std::string>{"a", "", "b"}));
+}
+
+TEST(test_mapped_file, split_lines) {
+    static std::string const kText{"1.1.1.1\t1\t1\n22.22.22.22\t2\t2\n\n4.4.4.4\t4\t4\n5.5.5.5"};
+
+    for (size_t num_parts{1}; num_parts <= kText.size() + 1; ++num_parts) {
+        auto const parts{MappedFile::SplitLines(kText, num_parts)};
+        ASSERT_LE(parts.size(), num_parts);
+        std::vector<std::string> split_lines{};
+        for (size_t i{}; i < parts.size(); ++i) {
+            ASSERT_FALSE(parts[i].empty());
+            if (i + 1 < parts.size()) {
+                ASSERT_EQ(parts[i].back(), '\n');
+            }
+            auto const part_lines{lines(parts[i])};
+            split_lines.insert(split_lines.end(), part_lines.begin(), part_lines.end());
+        }
+        ASSERT_EQ(split_lines, lines(kText)) << num_parts;
+    }
+}
+
+TEST(test_mapped_file, estimate_lines) {
+    static constexpr size_t kNumLines{100000};
+
+    // Небольшой текст считается точно
+    ASSERT_EQ(MappedFile::EstimateLines(""), 1);
+    ASSERT_EQ(MappedFile::EstimateLines("a\nb\n"), 3);
+
+    // Строки разной длины: оценка сверху не больше запаса 1/16 и небольшой ошибки выборки
+    std::string text{};
+    for (size_t i{}; i < kNumLines; ++i) {
+        text += std::to_string(i % 256) + "." + std::to_string(i * 7 % 256) + ".1.2\t" + std::to_string(i) + "\n";
+    }
+    size_t const estimate{MappedFile::EstimateLines(text)};
+    ASSERT_GE(estimate, kNumLines);
+    ASSERT_LE(estimate, kNumLines + kNumLines / 8);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "radix_sort.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_radix_sort, descending) {
+    static constexpr int kSizes[]{0, 1, 255, 256, 10000};
+
+    std::mt19937 gen{42};
+    for (int const size: kSizes) {
+        std::vector<uint32_t> keys(size);
+        std::ranges::generate(keys, gen);
+        // Общий старший байт: проход по нему пропускается
+        std::vector<uint32_t> same_high(keys);
+        std::ranges::for_each(same_high, [](uint32_t &key) { key = 0x2E000000u | (key & 0xFFFFu); });
+
+        for (auto ethalon: {keys, same_high}) {
+            auto vec{ethalon};
+            RadixSort::Descending(vec, [](uint32_t const key) { return key; });
+            std::ranges::sort(ethalon, std::greater{});
+            ASSERT_EQ(vec, ethalon);
+        }
+    }
+}
+
+TEST(test_radix_sort, stable_records) {
+    // Меньше и больше порога поразрядной сортировки
+    static constexpr int kSizes[]{100, 1000};
+
+    for (int const size: kSizes) {
+        std::vector<std::tuple<std::string, uint32_t> > vec{};
+        for (int i{}; i < size; ++i) {
+            vec.emplace_back(std::to_string(i), static_cast<uint32_t>(i % 7));
+        }
+        auto ethalon{vec};
+        RadixSort::Descending(vec, [](auto const &rec) { return std::get<1>(rec); });
+        std::ranges::stable_sort(ethalon, [](auto const &lhs, auto const &rhs) {
+            return std::get<1>(rhs) < std::get<1>(lhs);
+        });
+        ASSERT_EQ(vec, ethalon) << size;
+    }
+}
+
+TEST(test_radix_sort, parallel) {
+    // Меньше порога - сортировка в вызывающем потоке, больше - параллельная
+    static constexpr int kSizes[]{0, 1, 1000, 1 << 16, 300000};
+    // 1000 потоков больше числа корзин старшего разряда: сортировка ограничивает их числом корзин
+    static constexpr unsigned kThreads[]{1, 2, 3, 8, 1000};
+
+    std::mt19937 gen{7};
+    for (int const size: kSizes) {
+        std::vector<uint32_t> keys(size);
+        std::ranges::generate(keys, gen);
+        // Один старший байт: все ключи в одной корзине
+        std::vector<uint32_t> same_high(keys);
+        std::ranges::for_each(same_high, [](uint32_t &key) { key = 0x2E000000u | (key & 0xFFFFu); });
+        // Мало различных ключей: большинство младших проходов пропускается
+        std::vector<uint32_t> few(keys);
+        std::ranges::for_each(few, [](uint32_t &key) { key = (key % 5) << 24 | 0x0101u; });
+
+        for (auto ethalon: {keys, same_high, few}) {
+            auto sorted{ethalon};
+            std::ranges::sort(sorted, std::greater{});
+            for (unsigned const threads: kThreads) {
+                auto vec{ethalon};
+                RadixSort::Descending(vec, std::identity{}, threads);
+                ASSERT_EQ(vec, sorted) << size << ' ' << threads;
+            }
+        }
+    }
+}
+
+TEST(test_radix_sort, parallel_stable_records) {
+    static constexpr int kSize{100000};
+    static constexpr unsigned kThreads{4};
+
+    std::vector<std::tuple<uint32_t, uint32_t> > vec{};
+    for (int i{}; i < kSize; ++i) {
+        vec.emplace_back(static_cast<uint32_t>(i), static_cast<uint32_t>(i % 1000) * 0x00FEDCBAu);
+    }
+    auto ethalon{vec};
+    RadixSort::Descending(vec, [](auto const &rec) { return std::get<1>(rec); }, kThreads);
+    std::ranges::stable_sort(ethalon, [](auto const &lhs, auto const &rhs) {
+        return std::get<1>(rhs) < std::get<1>(lhs);
+    });
+    ASSERT_EQ(vec, ethalon);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <vector>
+#include "rule_set.h"
+
+namespace {
+    static constexpr size_t kWordBits{64};
+
+    /// Бит правила в маске
+    bool test(std::vector<uint64_t> const &mask, size_t const rule) {
+        return (mask[rule / kWordBits] >> (rule % kWordBits) & 1) != 0;
+    }
+
+    /// Маска адреса
+    std::vector<uint64_t> match(RuleSet const &rule_set, uint32_t const ip) {
+        std::vector<uint64_t> mask(rule_set.Words());
+        rule_set.Match(ip, mask);
+        return mask;
+    }
+}
+
+//--------------------TESTS--------------------
+
+TEST(test_rule_set, patterns) {
+    RuleSet rule_set{};
+    ASSERT_TRUE(rule_set.Add("46.70.*.*"));
+    ASSERT_TRUE(rule_set.Add("any==46"));
+    ASSERT_TRUE(rule_set.Add("10.0-15.*.1"));
+    ASSERT_TRUE(rule_set.Add("192.168.16.0/20"));
+    ASSERT_TRUE(rule_set.Add("0.0.0.0/0"));
+    for (auto const pattern: {"46.70.*", "46.70.*.*.1", "46.70..1", "256.*.*.*", "1-.*.*.*", "5-4.*.*.*",
+                              "any==256", "any=46", "1.2.3.4/33", "1.2.3/8", "*.*.*.+1", ""}) {
+        ASSERT_FALSE(rule_set.Add(pattern)) << pattern;
+    }
+    ASSERT_EQ(rule_set.Size(), 5);
+    ASSERT_EQ(rule_set.Words(), 1);
+
+    auto const mask{match(rule_set, 0x2E467148)};
+    ASSERT_TRUE(test(mask, 0));
+    ASSERT_TRUE(test(mask, 1));
+    ASSERT_FALSE(test(mask, 2));
+    ASSERT_TRUE(test(mask, 4));
+    ASSERT_TRUE(test(match(rule_set, 0x01022E04), 1));
+    ASSERT_FALSE(test(match(rule_set, 0x2E470000), 0));
+    ASSERT_TRUE(test(match(rule_set, 0x0A0F0001), 2));
+    ASSERT_FALSE(test(match(rule_set, 0x0A100001), 2));
+    ASSERT_FALSE(test(match(rule_set, 0x0A0F0002), 2));
+    ASSERT_TRUE(test(match(rule_set, 0xC0A81FFF), 3));
+    ASSERT_FALSE(test(match(rule_set, 0xC0A82000), 3));
+    ASSERT_FALSE(test(match(rule_set, 0xC0A80FFF), 3));
+}
+
+TEST(test_rule_set, brute_force) {
+    static constexpr size_t kNumRules{300};
+    static constexpr int kNumIps{20000};
+
+    std::mt19937 gen{1};
+    auto const octet{[&gen] { return static_cast<uint32_t>(gen() % 256); }};
+    RuleSet rule_set{};
+    std::vector<std::function<bool(uint32_t)> > reference{};
+    while (reference.size() < kNumRules) {
+        if (gen() % 4 == 0) {
+            uint32_t const value{octet()};
+            std::string pattern{"any=="};
+            pattern += std::to_string(value);
+            ASSERT_TRUE(rule_set.Add(pattern));
+            reference.emplace_back([value](uint32_t const ip) {
+                return (ip >> 24) == value || (ip >> 16 & 0xFF) == value || (ip >> 8 & 0xFF) == value ||
+                       (ip & 0xFF) == value;
+            });
+            continue;
+        }
+        // Октет: любое значение, одно значение или диапазон
+        std::array<std::pair<uint32_t, uint32_t>, 4> ranges{};
+        std::string pattern{};
+        for (auto &[first, last]: ranges) {
+            if (!pattern.empty()) {
+                pattern += '.';
+            }
+            switch (gen() % 3) {
+                case 0:
+                    first = 0;
+                    last = 255;
+                    pattern += '*';
+                    break;
+                case 1:
+                    first = last = octet();
+                    pattern += std::to_string(first);
+                    break;
+                default:
+                    first = octet();
+                    last = first + static_cast<uint32_t>(gen() % (256 - first));
+                    pattern += std::to_string(first);
+                    pattern += '-';
+                    pattern += std::to_string(last);
+            }
+        }
+        ASSERT_TRUE(rule_set.Add(pattern)) << pattern;
+        reference.emplace_back([ranges](uint32_t const ip) {
+            for (int i{}; i < 4; ++i) {
+                uint32_t const value{ip >> (24 - 8 * i) & 0xFF};
+                if (value < ranges[i].first || ranges[i].second < value) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+    ASSERT_EQ(rule_set.Words(), (kNumRules + kWordBits - 1) / kWordBits);
+
+    // Мало различных значений октетов, чтобы правила совпадали чаще
+    for (int i{}; i < kNumIps; ++i) {
+        auto const ip{static_cast<uint32_t>((gen() % 8) << 24 | (gen() % 256) << 16 | (gen() % 8) << 8 | octet())};
+        auto const mask{match(rule_set, ip)};
+        for (size_t rule{}; rule < kNumRules; ++rule) {
+            ASSERT_EQ(test(mask, rule), reference[rule](ip)) << rule_set.Rules()[rule].pattern << ' ' << ip;
+        }
+    }
+}
+
+TEST(test_rule_set, load) {
+    auto const file{std::filesystem::temp_directory_path() / "test_rule_set.txt"};
+    {
+        std::ofstream dst{file};
+        dst << "# rules\n"
+                "46.70.*.*  task_3.txt\n"
+                "  any==46 # no output\n"
+                "\n"
+                "46.70.*\n"
+                "1.0.0.0/8\ttask_2.txt\r\n";
+    }
+    RuleSet rule_set{};
+    ASSERT_TRUE(rule_set.Load(file.string()));
+    ASSERT_EQ(rule_set.Size(), 3);
+    ASSERT_EQ(rule_set.Rejected(), 1);
+    ASSERT_EQ(rule_set.Rules()[0].pattern, "46.70.*.*");
+    ASSERT_EQ(rule_set.Rules()[0].output, "task_3.txt");
+    ASSERT_EQ(rule_set.Rules()[1].output, file.string() + ".2");
+    ASSERT_EQ(rule_set.Rules()[2].output, "task_2.txt");
+    std::filesystem::remove(file);
+
+    ASSERT_FALSE(rule_set.Load((std::filesystem::temp_directory_path() / "test_rule_set_missing.txt").string()));
+}
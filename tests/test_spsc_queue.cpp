@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include "spsc_queue.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_spsc_queue, capacity) {
+    SpscQueue<int> queue{3};
+    // Емкость округляется до 4
+    for (int i{}; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPush(i));
+    }
+    ASSERT_FALSE(queue.TryPush(4));
+
+    int value{};
+    for (int i{}; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(queue.TryPop(value));
+}
+
+TEST(test_spsc_queue, threads) {
+    static constexpr uint64_t kCount{100000};
+    static constexpr size_t kCapacity{8};
+
+    SpscQueue<uint64_t> queue{kCapacity};
+    uint64_t sum{};
+    bool ordered{true};
+    {
+        std::jthread consumer{[&queue, &sum, &ordered] {
+            for (uint64_t i{1}; i <= kCount; ++i) {
+                uint64_t const value{queue.Pop()};
+                ordered = ordered && value == i;
+                sum += value;
+            }
+        }};
+        for (uint64_t i{1}; i <= kCount; ++i) {
+            queue.Push(i);
+        }
+    }
+    ASSERT_TRUE(ordered);
+    ASSERT_EQ(sum, kCount * (kCount + 1) / 2);
+}
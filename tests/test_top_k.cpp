@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+#include "top_k.h"
+
+//--------------------TESTS--------------------
+
+TEST(test_top_k, descending) {
+    static constexpr size_t kSize{10000};
+    static constexpr size_t kLimits[]{0, 1, 2, 7, 100, kSize, 2 * kSize};
+
+    std::mt19937 gen{3};
+    std::vector<uint32_t> ips(kSize);
+    // Много повторов
+    std::ranges::generate(ips, [&gen] { return static_cast<uint32_t>(gen() % 500) << 20; });
+
+    for (bool const unique: {false, true}) {
+        auto sorted{ips};
+        std::ranges::sort(sorted, std::greater{});
+        if (unique) {
+            sorted.erase(std::ranges::unique(sorted).begin(), sorted.end());
+        }
+        for (size_t const k: kLimits) {
+            TopK top{k, unique};
+            for (uint32_t const ip: ips) {
+                top.Push(ip);
+            }
+            auto const result{top.Descending()};
+            std::vector<uint32_t> const ethalon(sorted.begin(),
+                                                sorted.begin() + static_cast<std::ptrdiff_t>(std::min(k, sorted.size())));
+            ASSERT_EQ(std::vector<uint32_t>(result.begin(), result.end()), ethalon) << k << ' ' << unique;
+        }
+    }
+}
+
+TEST(test_top_k, ascending_input) {
+    static constexpr uint32_t kSize{1000};
+    static constexpr size_t kLimit{10};
+
+    // Каждый адрес больше порога: буфер сжимается каждые kLimit адресов
+    TopK top{kLimit};
+    for (uint32_t ip{}; ip < kSize; ++ip) {
+        top.Push(ip);
+    }
+    auto const result{top.Descending()};
+    ASSERT_EQ(result.size(), kLimit);
+    ASSERT_EQ(result.front(), kSize - 1);
+    ASSERT_EQ(result.back(), kSize - kLimit);
+}